@@ -0,0 +1,206 @@
+// Micro-benchmark for the shared-memory ring de-interleave.
+//
+// Compares the original per-sample loop from processBlock (index arithmetic per sample and
+// channel, one scalar store at a time) against RingDeinterleave::readFromRing across block sizes
+// and output channel counts. The ring layout matches the sender: 10 interleaved channels, the
+// first two of which are dummies.
+//
+// A second table times readContiguous, the path processBlock actually takes for plain routes: the
+// compile-time specialised kernels for 2, 4, 8 and 10 outputs (10 reads the dummies too).
+//
+// A third table reads the same frames out of rings stored as int16, int24 and fp16 (see
+// SampleFormat.h) with readFromRingEncoded, against the float kernel. On x86 the SSSE3, AVX2 and
+// F16C decoders are picked at run time, so a plain build already measures them on a CPU that has
+// them. The ring fits in cache here, so this shows the decode cost without the bandwidth saving.
+//
+// Usage: DeinterleaveBenchmark [iterations]
+
+#include "RingDeinterleave.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    constexpr int totalSharedChannels = 10;
+    constexpr int dummyChannels = 2;
+    constexpr uint64_t ringFrames = 1 << 16;
+    constexpr uint64_t ringMask = ringFrames - 1;
+    constexpr int timingRounds = 5;
+
+    // The loop processBlock used before the kernel existed.
+    void referenceLoop (const float* ring, uint64_t readIndex, int numSamples, float* const* dest, int outputChannels,
+                        int firstChannel = dummyChannels)
+    {
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            uint64_t frameIndex = (readIndex + sample) & ringMask;
+            for (int ch = 0; ch < outputChannels; ++ch)
+            {
+                int sharedChannel = firstChannel + ch;
+                int sharedBufferIndex = (int) (frameIndex * totalSharedChannels) + sharedChannel;
+                dest[ch][sample] = ring[sharedBufferIndex];
+            }
+        }
+    }
+
+    template <typename Fn>
+    double nanosPerBlock (Fn&& fn, int numSamples, int iterations)
+    {
+        // Step the read position like a real stream so both wraparound and cache behaviour show up.
+        uint64_t readIndex = ringFrames - 3 * (uint64_t) numSamples / 2;
+
+        for (int i = 0; i < iterations / 10; ++i)
+        {
+            fn (readIndex);
+            readIndex += (uint64_t) numSamples;
+        }
+
+        // Best of a few rounds, so a preempted round on a busy machine doesn't decide the ratio.
+        double best = 0.0;
+
+        for (int round = 0; round < timingRounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < iterations / timingRounds; ++i)
+            {
+                fn (readIndex);
+                readIndex += (uint64_t) numSamples;
+            }
+
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            const double nanos = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count()
+                                   / (iterations / timingRounds);
+
+            if (round == 0 || nanos < best)
+                best = nanos;
+        }
+
+        return best;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::atoi (argv[1]) : 200000;
+
+    std::vector<float> ring (ringFrames * totalSharedChannels);
+    for (size_t i = 0; i < ring.size(); ++i)
+        ring[i] = (float) (i % 1024) / 1024.0f;
+
+   #if RING_DEINTERLEAVE_AVX
+    const char* kernelName = "AVX";
+   #elif RING_DEINTERLEAVE_SSE
+    const char* kernelName = "SSE";
+   #elif RING_DEINTERLEAVE_NEON
+    const char* kernelName = "NEON";
+   #else
+    const char* kernelName = "scalar";
+   #endif
+
+    std::printf ("De-interleave kernel: %s, %d iterations per case\n\n", kernelName, iterations);
+    std::printf ("%8s %9s %14s %14s %9s\n", "channels", "block", "loop ns/blk", "kernel ns/blk", "speedup");
+
+    float checksum = 0.0f;
+
+    for (int channels : { 2, 4, 8 })
+    {
+        for (int numSamples : { 32, 64, 128, 256, 512, 1024 })
+        {
+            std::vector<std::vector<float>> planar (channels, std::vector<float> (numSamples));
+            std::vector<float*> dest;
+            for (auto& ch : planar)
+                dest.push_back (ch.data());
+
+            const double loopNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                referenceLoop (ring.data(), readIndex, numSamples, dest.data(), channels);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            const double kernelNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                RingDeinterleave::readFromRing (ring.data(), ringMask, totalSharedChannels, dummyChannels,
+                                                readIndex, numSamples, dest.data(), channels);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            std::printf ("%8d %9d %14.1f %14.1f %8.2fx\n", channels, numSamples, loopNs, kernelNs, loopNs / kernelNs);
+        }
+    }
+
+    std::printf ("\n%8s %9s %14s %14s %9s\n", "outputs", "block", "loop ns/blk", "contig ns/blk", "speedup");
+
+    for (int channels : { 2, 4, 8, 10 })
+    {
+        const int firstChannel = channels + dummyChannels <= totalSharedChannels ? dummyChannels : 0;
+
+        for (int numSamples : { 32, 64, 128, 256, 512, 1024 })
+        {
+            std::vector<std::vector<float>> planar (channels, std::vector<float> (numSamples));
+            std::vector<float*> dest;
+            for (auto& ch : planar)
+                dest.push_back (ch.data());
+
+            const double loopNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                referenceLoop (ring.data(), readIndex, numSamples, dest.data(), channels, firstChannel);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            const double kernelNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                RingDeinterleave::readContiguous (ring.data(), ringMask, totalSharedChannels, firstChannel,
+                                                  readIndex, numSamples, dest.data(), channels);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            std::printf ("%8d %9d %14.1f %14.1f %8.2fx\n", channels, numSamples, loopNs, kernelNs, loopNs / kernelNs);
+        }
+    }
+
+    // The same reads from compact rings. Each ring holds the same samples, so only the decode and
+    // the bytes per frame differ.
+    std::printf ("\n%8s %9s %8s %12s %14s %9s\n", "format", "block", "B/frame", "float ns/blk", "decode ns/blk", "ratio");
+
+    const int channels = totalSharedChannels - dummyChannels;
+
+    for (auto encoding : { SampleFormat::int16, SampleFormat::int24, SampleFormat::float16 })
+    {
+        const int bytesPerFrame = totalSharedChannels * SampleFormat::bytesPerSample (encoding);
+        std::vector<uint8_t> encoded (ringFrames * (uint64_t) bytesPerFrame);
+        SampleFormat::encode (encoding, ring.data(), encoded.data(), (int) ring.size());
+
+        for (int numSamples : { 64, 256, 1024 })
+        {
+            std::vector<std::vector<float>> planar (channels, std::vector<float> (numSamples));
+            std::vector<float*> dest;
+            for (auto& ch : planar)
+                dest.push_back (ch.data());
+
+            const double floatNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                RingDeinterleave::readContiguous (ring.data(), ringMask, totalSharedChannels, dummyChannels,
+                                                  readIndex, numSamples, dest.data(), channels);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            const double decodeNs = nanosPerBlock ([&] (uint64_t readIndex)
+            {
+                RingDeinterleave::readFromRingEncoded (encoded.data(), encoding, ringMask, totalSharedChannels, dummyChannels,
+                                                       readIndex, numSamples, dest.data(), channels);
+                checksum += dest[0][0];
+            }, numSamples, iterations);
+
+            std::printf ("%8s %9d %8d %12.1f %14.1f %8.2fx\n", SampleFormat::getName (encoding), numSamples,
+                         bytesPerFrame, floatNs, decodeNs, floatNs / decodeNs);
+        }
+    }
+
+    // Keeps the optimiser from discarding the copies.
+    std::printf ("\n(checksum %f)\n", (double) checksum);
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Micro-benchmark for the live fields of a self-describing segment (see SegmentHeader.h).
+//
+// Runs a sender and a receiver thread against one segment header, each doing per block exactly
+// what the real ones do with the live fields: the sender stores writeIndex (and now and then
+// ringFormat), the receiver loads writeIndex, isActive and ringFormat and stores readIndex and
+// currentLatency. Between blocks each side does a little unrelated work, so the two run at their
+// own pace rather than in lock step. Reports the time each side spends on its shared-field
+// accesses, per block, for layout version 1 (all live fields on one cache line) and version 2
+// (one line per side). Pin the threads to different cores (the default on Linux) or the
+// difference mostly disappears.
+//
+// Usage: HeaderLayoutBenchmark [blocks per run] [work per block]
+
+#include "SegmentHeader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#if defined (__linux__)
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    volatile uint64_t discard = 0;   // Keeps the receiver's loads from being optimised away
+
+    struct alignas (64) Segment
+    {
+        unsigned char bytes[sizeof (SegmentLayout::SegmentV2)];
+    };
+
+    void pinToCore (std::thread& thread, int core)
+    {
+       #if defined (__linux__)
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        CPU_SET (core, &set);
+        pthread_setaffinity_np (thread.native_handle(), sizeof (set), &set);
+       #else
+        (void) thread;
+        (void) core;
+       #endif
+    }
+
+    // Stands in for the audio each side processes between touching the header.
+    float busyWork (int amount)
+    {
+        volatile float x = 1.0f;
+
+        for (int i = 0; i < amount; ++i)
+            x = x * 0.999f + 0.001f;
+
+        return x;
+    }
+
+    struct Result
+    {
+        double senderNs = 0.0, receiverNs = 0.0;
+    };
+
+    Result run (uint32_t layoutVersion, int blocks, int work)
+    {
+        Segment storage {};
+        auto& header = *reinterpret_cast<SegmentLayout::Header*> (storage.bytes);
+        SegmentLayout::describe (header, 1 << 16, 10, 48000.0, layoutVersion);
+        SegmentLayout::publish (header);
+        const auto live = SegmentLayout::locate (header);
+        live.isActive->store (1);
+
+        std::atomic<bool> go { false }, senderDone { false };
+        Result result;
+
+        std::thread sender ([&]
+        {
+            while (! go.load()) {}
+
+            Clock::duration spent {};
+
+            for (int block = 1; block <= blocks; ++block)
+            {
+                busyWork (work);
+
+                const auto start = Clock::now();
+                live.writeIndex->store ((uint64_t) block * 256, std::memory_order_release);
+
+                if (block % 64 == 0)
+                    live.ringFormat->store ((uint64_t) block * 256, std::memory_order_release);
+
+                spent += Clock::now() - start;
+            }
+
+            result.senderNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (spent).count() / blocks;
+            senderDone.store (true);
+        });
+
+        std::thread receiver ([&]
+        {
+            while (! go.load()) {}
+
+            Clock::duration spent {};
+            uint64_t readIndex = 0, sink = 0;
+            int count = 0;
+
+            while (! senderDone.load (std::memory_order_relaxed))
+            {
+                busyWork (work);
+
+                const auto start = Clock::now();
+                const uint64_t writeIndex = live.writeIndex->load (std::memory_order_acquire);
+                sink += live.isActive->load (std::memory_order_acquire) + live.ringFormat->load (std::memory_order_acquire);
+                readIndex = std::max (readIndex, writeIndex);
+                live.readIndex->store (readIndex, std::memory_order_release);
+                live.currentLatency->store ((double) (writeIndex - readIndex), std::memory_order_relaxed);
+                spent += Clock::now() - start;
+                ++count;
+            }
+
+            result.receiverNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (spent).count()
+                                / std::max (1, count);
+
+            discard = sink;
+        });
+
+        pinToCore (sender, 0);
+        pinToCore (receiver, (int) std::min (std::thread::hardware_concurrency() - 1, 2u));
+        go.store (true);
+        sender.join();
+        receiver.join();
+        return result;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const int blocks = argc > 1 ? std::atoi (argv[1]) : 2000000;
+    const int work = argc > 2 ? std::atoi (argv[2]) : 50;
+
+    std::printf ("%d blocks, %d units of work per block\n\n", blocks, work);
+    std::printf ("layout   sender ns/block   receiver ns/block\n");
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (uint32_t version = SegmentLayout::oldestVersion; version <= SegmentLayout::version; ++version)
+        {
+            const auto result = run (version, blocks, work);
+            std::printf ("v%u       %15.1f   %17.1f\n", version, result.senderNs, result.receiverNs);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+// Headless benchmark for AudioReceiverAudioProcessor::processBlock.
+//
+// Starts a StandInSender on a private stream name in a background thread, connects a receiver
+// processor to it and calls processBlock on a simulated real-time host callback. The sender writes
+// timecode into the first audio channel, so for every block the frame that came out can be traced
+// back to the moment it was written. Reports processBlock cost, underruns and end-to-end latency
+// (sender write to receiver output) percentiles. Runs on a plain Linux box, no DAW needed.
+// With --format other than float the sender writes a compact encoding, which can't carry the
+// timecode, so only processBlock cost and underruns are reported. --ring has the sender write a
+// self-describing segment (see SegmentHeader.h) with a ring of that many frames. --sender-rate runs
+// the sender at another rate than the host, so every block goes through the rate converter
+// (implies a self-describing segment, the only kind that states its rate). --max-block makes the
+// host vary its block size at random between half of --block and this, bigger than it announced
+// in prepareToPlay, the way some hosts do for offline renders and automation splits. --layout picks
+// the self-describing segment's layout version (implies --ring), e.g. to compare version 1's shared
+// cache line for the indices against version 2's separate ones. Version 2 senders publish time
+// anchors, so the receiver lines up with the sender's clock and reports how far behind it plays.
+//
+// Usage: ProcessBlockBenchmark [--seconds 10] [--rate 48000] [--block 256] [--sender-block 256]
+//                              [--jitter <pattern>] [--drift <ppm>] [--buffer auto|<samples>]
+//                              [--format float|int16|int24|fp16] [--ring <frames>] [--sender-rate <Hz>]
+//                              [--max-block <samples>] [--layout 1|2]
+// See StandInSender.h for the jitter patterns.
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "StandInSender.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    double percentile (std::vector<double> values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort (values.begin(), values.end());
+        const size_t index = (size_t) std::min ((double) values.size() - 1.0, p / 100.0 * (double) values.size());
+        return values[index];
+    }
+
+    void printRow (const char* name, const std::vector<double>& values, const char* unit)
+    {
+        double mean = 0.0;
+        for (double v : values)
+            mean += v;
+        mean /= (double) std::max<size_t> (1, values.size());
+
+        std::printf ("%-20s mean %9.1f  p50 %9.1f  p95 %9.1f  p99 %9.1f  max %9.1f  %s\n", name, mean,
+                     percentile (values, 50.0), percentile (values, 95.0), percentile (values, 99.0),
+                     percentile (values, 100.0), unit);
+    }
+
+    void printUsage()
+    {
+        std::fprintf (stderr, "Usage: ProcessBlockBenchmark [--seconds 10] [--rate 48000] [--block 256] [--sender-block 256]\n"
+                              "                             [--jitter <pattern>] [--drift <ppm>] [--buffer auto|<samples>]\n"
+                              "                             [--format float|int16|int24|fp16] [--ring <frames>] [--sender-rate <Hz>]\n"
+                              "                             [--max-block <samples>] [--layout 1|2]\n");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    double seconds = 10.0, warmupSeconds = 1.0, sampleRate = 48000.0, senderRate = 0.0;
+    int blockSize = 256, maxBlockSize = 0;
+    juce::String bufferSetting ("auto");
+
+    StandInSender::Options senderOptions;
+    senderOptions.name = "/ARBench" + std::to_string ((int) getpid());
+    senderOptions.label = "processBlock benchmark";
+    senderOptions.timecode = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--seconds" && hasValue)             seconds = std::atof (argv[++i]);
+        else if (arg == "--rate" && hasValue)           sampleRate = std::atof (argv[++i]);
+        else if (arg == "--block" && hasValue)          blockSize = std::atoi (argv[++i]);
+        else if (arg == "--sender-block" && hasValue)   senderOptions.blockSize = std::atoi (argv[++i]);
+        else if (arg == "--jitter" && hasValue)         senderOptions.jitter = argv[++i];
+        else if (arg == "--drift" && hasValue)          senderOptions.driftPpm = std::atof (argv[++i]);
+        else if (arg == "--buffer" && hasValue)         bufferSetting = argv[++i];
+        else if (arg == "--format" && hasValue)         senderOptions.format = argv[++i];
+        else if (arg == "--ring" && hasValue)           senderOptions.ringFrames = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--sender-rate" && hasValue)    senderRate = std::atof (argv[++i]);
+        else if (arg == "--max-block" && hasValue)      maxBlockSize = std::atoi (argv[++i]);
+        else if (arg == "--layout" && hasValue)         senderOptions.layoutVersion = (uint32_t) std::atoi (argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    senderOptions.sampleRate = senderRate > 0.0 ? senderRate : sampleRate;
+
+    if ((senderOptions.sampleRate != sampleRate || senderOptions.layoutVersion != SegmentLayout::version)
+        && senderOptions.ringFrames == 0)
+        senderOptions.ringFrames = uint64_t (1) << 15;
+    senderOptions.timecode = senderOptions.format == "float";
+
+    maxBlockSize = std::max (maxBlockSize, blockSize);
+
+    if (sampleRate <= 0.0 || blockSize <= 0 || senderOptions.blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Sender
+    StandInSender sender (senderOptions);
+
+    if (! sender.open())
+        return 1;
+
+    std::atomic<bool> senderRunning { true };
+    std::thread senderThread ([&] { sender.run (senderRunning, 0.0); });
+
+    // Receiver
+    AudioReceiverAudioProcessor processor;
+    processor.setStreamName (senderOptions.name);
+
+    if (bufferSetting != "auto")
+        processor.getJitterBuffer().setFixedSamples (bufferSetting.getDoubleValue());
+
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    juce::AudioBuffer<float> buffer (processor.getTotalNumOutputChannels(), maxBlockSize);
+    juce::MidiBuffer midi;
+    juce::Random blockSizes (1);
+
+    std::vector<double> blockNs, latencyMs;
+    const int numBlocks = (int) (seconds * sampleRate / blockSize);
+    const int warmupBlocks = (int) (warmupSeconds * sampleRate / blockSize);
+    blockNs.reserve ((size_t) numBlocks);
+    latencyMs.reserve ((size_t) numBlocks);
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t underrunsAtStart = 0, samplesCalled = 0;
+
+    std::printf ("Receiving %s: %.0f Hz from %.0f Hz, host block %d-%d, sender block %d, jitter %s, drift %+.1f ppm, buffer %s, format %s, %s\n",
+                 senderOptions.name.c_str(), sampleRate, senderOptions.sampleRate,
+                 maxBlockSize > blockSize ? std::max (1, blockSize / 2) : blockSize, maxBlockSize, senderOptions.blockSize,
+                 senderOptions.jitter.c_str(), senderOptions.driftPpm, bufferSetting.toRawUTF8(),
+                 senderOptions.format.c_str(),
+                 senderOptions.ringFrames == 0 ? "legacy layout" : ("layout v" + std::to_string (senderOptions.layoutVersion)).c_str());
+    int silentBlocks = 0, concealedBlocks = 0;
+
+    for (int block = 0; block < numBlocks + warmupBlocks; ++block)
+    {
+        // Simulated host callback: each block is due once the previous ones' samples have played.
+        const int smallest = std::max (1, blockSize / 2);
+        const int numSamples = maxBlockSize > blockSize ? smallest + blockSizes.nextInt (maxBlockSize - smallest + 1) : blockSize;
+        std::this_thread::sleep_until (start + std::chrono::duration_cast<std::chrono::steady_clock::duration> (
+                                                   std::chrono::duration<double> ((double) samplesCalled / sampleRate)));
+        samplesCalled += (uint64_t) numSamples;
+        buffer.setSize (buffer.getNumChannels(), numSamples, false, false, true);
+
+        const uint64_t concealedBefore = processor.getReceiverMetrics().concealedBlocks.load();
+        const int64_t before = StandInSender::nowNs();
+        processor.processBlock (buffer, midi);
+        const int64_t after = StandInSender::nowNs();
+
+        if (block == warmupBlocks)
+            underrunsAtStart = processor.getReceiverMetrics().bufferUnderruns.load();
+
+        if (block < warmupBlocks)
+            continue;
+
+        blockNs.push_back ((double) (after - before));
+
+        // Silence means nothing was played this block (rebuffering or underrun). Blocks with
+        // concealed or faded-in audio don't carry exact timecode, so they don't count for latency.
+        const bool concealed = processor.getReceiverMetrics().concealedBlocks.load() != concealedBefore;
+        const float timecode = buffer.getSample (0, 0);
+
+        if (buffer.getMagnitude (0, 0, numSamples) == 0.0f)
+            ++silentBlocks;
+
+        if (concealed)
+            ++concealedBlocks;
+
+        if (timecode != 0.0f && senderOptions.timecode && ! concealed)
+        {
+            const uint64_t frame = StandInSender::decodeTimecode (timecode, sender.getWriteIndex());
+            const int64_t written = sender.getWriteTimeNs (frame);
+
+            if (written > 0)
+                latencyMs.push_back ((double) (after - written) * 1.0e-6);
+        }
+    }
+
+    processor.updateReportedLatency();
+
+    const auto& metrics = processor.getReceiverMetrics();
+    std::printf ("\n");
+    printRow ("processBlock", blockNs, "ns/block");
+    printRow ("end-to-end latency", latencyMs, "ms");
+    std::printf ("underruns %llu, resyncs %llu, concealments %llu, blocks without audio %d, with concealed audio %d, of %d\n",
+                 (unsigned long long) (metrics.bufferUnderruns.load() - underrunsAtStart),
+                 (unsigned long long) metrics.resyncs.load(), (unsigned long long) metrics.concealments.load(),
+                 silentBlocks, concealedBlocks, numBlocks);
+    std::printf ("buffer target %.0f frames, reported latency %d samples, drift %+.1f ppm, conversion ratio %.5f\n",
+                 metrics.targetFill.load(), processor.getLatencySamples(), metrics.driftPpm.load(), metrics.conversionRatio.load());
+
+    // Stays put across runs and resyncs once aligned; without anchors it is whatever the ring held.
+    static const char* const alignedTo[] = { "ring fill", "sender clock", "host transport" };
+    std::printf ("aligned to %s, %.2f ms behind the sender's clock\n",
+                 alignedTo[std::min (2u, metrics.alignedTo.load())], metrics.timelineOffsetMs.load());
+
+    processor.releaseResources();
+    senderRunning.store (false);
+    senderThread.join();
+    sender.close();
+    return 0;
+}
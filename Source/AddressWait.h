@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if defined (__linux__)
+ #include <climits>
+ #include <ctime>
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif defined (__APPLE__)
+ #include <AvailabilityMacros.h>
+ #if defined (MAC_OS_VERSION_14_4) && MAC_OS_X_VERSION_MAX_ALLOWED >= MAC_OS_VERSION_14_4
+  #include <os/os_sync_wait_on_address.h>
+  #define AUDIORECEIVER_HAS_OS_SYNC_WAIT 1
+ #endif
+#endif
+
+// Wait/wake on a word in shared memory, across processes: a shared (not process-private) futex on
+// Linux, os_sync_wait_on_address with the shared flag on macOS 14.4+. Doorbell.h and FrameWaiter.h
+// are built on it.
+//
+// wait() blocks while the word still holds `expected`, until a wakeAll() on the same word or the
+// timeout, and may also return spuriously; callers re-check the word either way. It returns false
+// without blocking when the platform has no such primitive, and the caller falls back to sleeping.
+// A futex is 32 bits, so on Linux a 64-bit word is waited on through its low half, which changes
+// whenever the value does for a counter that only counts up (little-endian only).
+//
+// Standard library and OS calls only, so the sender can share it.
+namespace AddressWait
+{
+    inline bool wait (const std::atomic<uint32_t>& word, uint32_t expected, int64_t timeoutNs) noexcept
+    {
+       #if defined (__linux__)
+        timespec timeout { (time_t) (timeoutNs / 1000000000), (long) (timeoutNs % 1000000000) };
+        syscall (SYS_futex, reinterpret_cast<const uint32_t*> (&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+        return true;
+       #elif defined (AUDIORECEIVER_HAS_OS_SYNC_WAIT)
+        if (__builtin_available (macOS 14.4, *))
+        {
+            os_sync_wait_on_address_with_timeout (const_cast<std::atomic<uint32_t>*> (&word), expected, sizeof (uint32_t),
+                                                  OS_SYNC_WAIT_ON_ADDRESS_SHARED, OS_CLOCK_MACH_ABSOLUTE_TIME,
+                                                  (uint64_t) timeoutNs);
+            return true;
+        }
+
+        return false;
+       #else
+        (void) word; (void) expected; (void) timeoutNs;
+        return false;
+       #endif
+    }
+
+    inline bool wait (const std::atomic<uint64_t>& word, uint64_t expected, int64_t timeoutNs) noexcept
+    {
+       #if defined (__linux__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // Returns at once if the low word no longer matches, i.e. the value moved.
+        timespec timeout { (time_t) (timeoutNs / 1000000000), (long) (timeoutNs % 1000000000) };
+        syscall (SYS_futex, reinterpret_cast<const uint32_t*> (&word), FUTEX_WAIT, (uint32_t) expected, &timeout, nullptr, 0);
+        return true;
+       #elif defined (AUDIORECEIVER_HAS_OS_SYNC_WAIT)
+        if (__builtin_available (macOS 14.4, *))
+        {
+            os_sync_wait_on_address_with_timeout (const_cast<std::atomic<uint64_t>*> (&word), expected, sizeof (uint64_t),
+                                                  OS_SYNC_WAIT_ON_ADDRESS_SHARED, OS_CLOCK_MACH_ABSOLUTE_TIME,
+                                                  (uint64_t) timeoutNs);
+            return true;
+        }
+
+        return false;
+       #else
+        (void) word; (void) expected; (void) timeoutNs;
+        return false;
+       #endif
+    }
+
+    // Wakes every process blocked in wait() on the word. One syscall, whether or not anyone waits.
+    inline void wakeAll (std::atomic<uint32_t>& word) noexcept
+    {
+       #if defined (__linux__)
+        syscall (SYS_futex, reinterpret_cast<uint32_t*> (&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+       #elif defined (AUDIORECEIVER_HAS_OS_SYNC_WAIT)
+        if (__builtin_available (macOS 14.4, *))
+            os_sync_wake_by_address_all (&word, sizeof (uint32_t), OS_SYNC_WAKE_BY_ADDRESS_SHARED);
+       #else
+        (void) word;
+       #endif
+    }
+
+    inline void wakeAll (std::atomic<uint64_t>& word) noexcept
+    {
+       #if defined (__linux__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        syscall (SYS_futex, reinterpret_cast<uint32_t*> (&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+       #elif defined (AUDIORECEIVER_HAS_OS_SYNC_WAIT)
+        if (__builtin_available (macOS 14.4, *))
+            os_sync_wake_by_address_all (&word, sizeof (uint64_t), OS_SYNC_WAKE_BY_ADDRESS_SHARED);
+       #else
+        (void) word;
+       #endif
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Follows a stream's timeline from (frame, clock) anchors: frame f belongs to clock reading t, and
+// the frames after it follow at a nominal rate.
+//
+// Anchors come with the jitter of whoever took them (a callback that ran late, a thread that woke
+// late), so each one only pulls the timeline part of the way towards itself: a first-order loop
+// that averages over about `1 / smoothing` anchors. Rate mismatch between the stream's clock and
+// the monotonic clock shows up as a steady lag of a few microseconds, far below a sample period at
+// the rates we run. An anchor that misses the timeline by more than restartAfterNs (a restart, a
+// transport relocate, a stall) starts it over. Audio thread, no allocation.
+class AnchorTimeline
+{
+public:
+    void prepare (double newFrameRate) noexcept
+    {
+        frameRate = newFrameRate > 0.0 ? newFrameRate : 48000.0;
+        reset();
+    }
+
+    void reset() noexcept   { valid = false; }
+    bool isValid() const noexcept   { return valid; }
+
+    // Returns false if the anchor didn't fit and the timeline started over from it.
+    bool update (uint64_t frame, int64_t clockNs) noexcept
+    {
+        if (valid && frame >= baseFrame)
+        {
+            const double predicted = baseClockNs + (double) (frame - baseFrame) * 1.0e9 / frameRate;
+            const double error = (double) clockNs - predicted;
+
+            if (std::abs (error) < restartAfterNs)
+            {
+                baseFrame = frame;
+                baseClockNs = predicted + error * smoothing;
+                return true;
+            }
+        }
+
+        baseFrame = frame;
+        baseClockNs = (double) clockNs;
+        valid = true;
+        return false;
+    }
+
+    // Fractional frame at a clock reading (only meaningful once isValid()).
+    double frameAt (int64_t clockNs) const noexcept
+    {
+        return (double) baseFrame + ((double) clockNs - baseClockNs) * frameRate * 1.0e-9;
+    }
+
+    int64_t clockAt (uint64_t frame) const noexcept
+    {
+        return (int64_t) std::llround (baseClockNs + ((double) frame - (double) baseFrame) * 1.0e9 / frameRate);
+    }
+
+private:
+    static constexpr double smoothing = 0.125;
+    static constexpr double restartAfterNs = 20.0e6;
+
+    double frameRate = 48000.0;
+    bool valid = false;
+    uint64_t baseFrame = 0;
+    double baseClockNs = 0.0;
+};
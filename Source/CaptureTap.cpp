@@ -0,0 +1,223 @@
+#include "CaptureTap.h"
+
+namespace
+{
+    // About five seconds at 48 kHz: the writer drains every drainIntervalMs, so only a disk that
+    // stalls for seconds makes the audio thread drop anything.
+    constexpr int fifoFrames = 1 << 18;
+    constexpr int drainIntervalMs = 100;
+
+    // Output stream buffer; the WAV writer's small writes reach the disk in pieces this big.
+    constexpr size_t fileBufferBytes = 1 << 20;
+}
+
+//==============================================================================
+// One capture: the FIFO, the file and the thread draining one into the other. Destroyed on the
+// message thread once the audio thread can no longer be pushing into it; the destructor writes
+// whatever is still queued, finishes the file and leaves the final figures in `result`.
+class CaptureTap::Session : private juce::Thread
+{
+public:
+    Session(std::unique_ptr<juce::AudioFormatWriter> writerToUse, const juce::File& fileBeingWritten, int numChannels,
+            Summary& resultToFill)
+        : juce::Thread("AudioReceiver capture"),
+          writer(std::move(writerToUse)),
+          fifo(numChannels, fifoFrames),
+          result(resultToFill)
+    {
+        summary.file = fileBeingWritten;
+        fifo.clear();
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~Session() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread(10000);
+
+        writer.reset();
+        result = getSummary();
+    }
+
+    // Audio thread.
+    void push(const float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        const uint64_t write = writePosition.load(std::memory_order_relaxed);
+        const uint64_t space = (uint64_t) fifoFrames - (write - readPosition.load(std::memory_order_acquire));
+
+        if ((uint64_t) numSamples > space)
+        {
+            droppedFrames.fetch_add((uint64_t) numSamples, std::memory_order_relaxed);
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // At most two pieces per channel: up to the end of the FIFO, then from its start.
+        const int start = (int) (write % (uint64_t) fifoFrames);
+        const int first = juce::jmin(numSamples, fifoFrames - start);
+
+        for (int channel = 0; channel < fifo.getNumChannels(); ++channel)
+        {
+            float* dest = fifo.getWritePointer(channel);
+
+            if (channel < numChannels)
+            {
+                juce::FloatVectorOperations::copy(dest + start, channels[channel], first);
+                juce::FloatVectorOperations::copy(dest, channels[channel] + first, numSamples - first);
+            }
+            else
+            {
+                juce::FloatVectorOperations::clear(dest + start, first);
+                juce::FloatVectorOperations::clear(dest, numSamples - first);
+            }
+        }
+
+        writePosition.store(write + (uint64_t) numSamples, std::memory_order_release);
+    }
+
+    // Any thread.
+    Summary getSummary() const
+    {
+        auto figures = summary;
+        figures.framesWritten = framesWritten.load(std::memory_order_relaxed);
+        figures.droppedFrames = droppedFrames.load(std::memory_order_relaxed);
+        figures.overflows = overflows.load(std::memory_order_relaxed);
+        figures.writeFailed = writeFailed.load(std::memory_order_relaxed);
+        return figures;
+    }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            wait(drainIntervalMs);
+            drain();
+        }
+
+        // The session only goes away after the audio thread has let go, so this is the last of it.
+        drain();
+    }
+
+    // Writes everything queued so far straight out of the FIFO, in at most two pieces.
+    void drain()
+    {
+        const uint64_t write = writePosition.load(std::memory_order_acquire);
+        uint64_t read = readPosition.load(std::memory_order_relaxed);
+
+        while (read != write)
+        {
+            const int start = (int) (read % (uint64_t) fifoFrames);
+            const int count = (int) juce::jmin(write - read, (uint64_t) (fifoFrames - start));
+
+            if (!writer->writeFromAudioSampleBuffer(fifo, start, count))
+                writeFailed.store(true, std::memory_order_relaxed);
+
+            read += (uint64_t) count;
+            framesWritten.fetch_add((uint64_t) count, std::memory_order_relaxed);
+            readPosition.store(read, std::memory_order_release);
+        }
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::AudioBuffer<float> fifo;
+    Summary summary;
+    Summary& result;
+
+    alignas (64) std::atomic<uint64_t> writePosition { 0 };
+    alignas (64) std::atomic<uint64_t> readPosition { 0 };
+    alignas (64) std::atomic<uint64_t> droppedFrames { 0 };
+    std::atomic<uint64_t> overflows { 0 };
+    std::atomic<uint64_t> framesWritten { 0 };
+    std::atomic<bool> writeFailed { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Session)
+};
+
+//==============================================================================
+juce::String CaptureTap::Summary::describe(double sampleRate) const
+{
+    juce::String text;
+    text << file.getFileName() << ", " << juce::String((double) framesWritten / juce::jmax(1.0, sampleRate), 1) << " s";
+
+    if (droppedFrames > 0)
+        text << ", " << (juce::int64) droppedFrames << " frames dropped in " << (juce::int64) overflows
+             << (overflows == 1 ? " block" : " blocks");
+
+    if (writeFailed)
+        text << ", write failed";
+
+    return text;
+}
+
+CaptureTap::CaptureTap() = default;
+
+CaptureTap::~CaptureTap()
+{
+    stop();
+}
+
+bool CaptureTap::start(const juce::File& file, double sampleRate, int numChannels, juce::String& error)
+{
+    stop();
+
+    // createOutputStream appends to an existing file.
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream(fileBufferBytes));
+
+    if (stream == nullptr)
+    {
+        error = "couldn't create " + file.getFullPathName();
+        return false;
+    }
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                        32, juce::StringPairArray(), 0));
+
+    if (writer == nullptr)
+    {
+        error = "WAV doesn't support " + juce::String(numChannels) + " channels at " + juce::String(sampleRate) + " Hz";
+        stream.reset();
+        file.deleteFile();
+        return false;
+    }
+
+    stream.release(); // The writer owns it now
+    handoff.publish(std::make_unique<Session>(std::move(writer), file, numChannels, lastSummary));
+    return true;
+}
+
+CaptureTap::Summary CaptureTap::stop()
+{
+    if (handoff.getCurrent() == nullptr)
+        return {};
+
+    lastSummary = {};
+    handoff.publish(nullptr);
+
+    // The audio thread lets go at the end of its current block at the latest; collecting the
+    // session then drains what it pushed and finishes the file.
+    while (handoff.hasRetiredConnections())
+    {
+        juce::Thread::sleep(1);
+        handoff.collectRetired();
+    }
+
+    return lastSummary;
+}
+
+CaptureTap::Summary CaptureTap::getProgress() const
+{
+    auto* session = handoff.getCurrent();
+    return session != nullptr ? session->getSummary() : Summary();
+}
+
+void CaptureTap::push(const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    ConnectionHandoff<Session>::ReadScope session(handoff);
+
+    if (session)
+        session->push(channels, numChannels, numSamples);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ConnectionHandoff.h"
+
+// Records what the receiver plays into a WAV file, so a glitch can be examined after the fact
+// without adding tracks (and latency) to the host session.
+//
+// The audio thread push()es every block into a single-producer, single-consumer FIFO that holds a
+// few seconds of audio: one relaxed load of the writer's position, a copy per channel, one release
+// store. It never blocks, allocates or makes a system call. A block that doesn't fit is dropped
+// whole and counted. A writer thread drains the FIFO a few times a second into 32-bit float WAV
+// through a large output buffer, so the disk sees a few big writes rather than one per block.
+//
+// start() and stop() run on the message thread. Each capture is a session handed to the audio
+// thread through ConnectionHandoff, so stopping never pulls the FIFO out from under a block: the
+// session finishes its file only after the audio thread has let go of it.
+class CaptureTap
+{
+public:
+    struct Summary
+    {
+        juce::File file;
+        uint64_t framesWritten = 0;
+        uint64_t droppedFrames = 0;   // Frames that didn't fit in the FIFO
+        uint64_t overflows = 0;       // Blocks that were dropped
+        bool writeFailed = false;
+
+        // E.g. "AudioReceiverCapture.wav, 12.5 s, 256 frames dropped in 1 block".
+        juce::String describe(double sampleRate) const;
+    };
+
+    CaptureTap();
+    ~CaptureTap();
+
+    //==============================================================================
+    // Message thread.
+
+    // Starts writing to `file`, ending any capture already running. Returns false, with the reason
+    // in `error`, if the file can't be created.
+    bool start(const juce::File& file, double sampleRate, int numChannels, juce::String& error);
+
+    // Blocks until the audio thread has let go and everything it pushed is on disk.
+    Summary stop();
+
+    bool isCapturing() const noexcept { return handoff.getCurrent() != nullptr; }
+
+    // Figures for the capture in progress (empty if none).
+    Summary getProgress() const;
+
+    //==============================================================================
+    // Audio thread. Channels beyond the capture's count are ignored, missing ones written silent.
+    void push(const float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    class Session;
+    ConnectionHandoff<Session> handoff;
+    Summary lastSummary;   // Filled in by a session as it is destroyed
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CaptureTap)
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "RingDeinterleave.h"
+
+// Wait-free per-channel level meter shared between the audio thread and the editor.
+//
+// The audio thread folds each block's peak and sum of squares (collected by the de-interleave
+// kernel while copying) into a running window and publishes the window's peak and RMS with plain
+// atomic stores. The editor reads whenever it likes and then calls markRead(); the audio thread
+// notices the new read count on its next block and starts a fresh window, so every editor frame
+// shows the peak and RMS of everything received since the previous frame.
+// Neither side ever blocks on the other.
+class ChannelLevelMeter
+{
+public:
+    static constexpr int maxChannels = RingDeinterleave::maxMeasuredChannels;
+
+    struct Reading
+    {
+        float peak = 0.0f; // Linear, post-gain
+        float rms = 0.0f;  // Linear, post-gain
+    };
+
+    //==============================================================================
+    // Audio thread. stats holds numChannels entries for this block, measured after the gain, or is
+    // null for a silent block.
+    void publish (const RingDeinterleave::ChannelStats* stats, int numChannels, int numSamples) noexcept
+    {
+        const uint32_t reads = readCount.load (std::memory_order_acquire);
+
+        if (reads != lastSeenReadCount || windowSamples > maxWindowSamples)
+        {
+            lastSeenReadCount = reads;
+            windowSamples = 0;
+
+            for (int ch = 0; ch < maxChannels; ++ch)
+                window[ch] = {};
+        }
+
+        if (stats != nullptr)
+            publishedChannels.store (numChannels < maxChannels ? numChannels : maxChannels, std::memory_order_relaxed);
+
+        const int channels = publishedChannels.load (std::memory_order_relaxed);
+
+        windowSamples += numSamples;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            if (stats != nullptr && ch < numChannels)
+            {
+                window[ch].peak = std::fmax (window[ch].peak, stats[ch].peak);
+                window[ch].sumSquares += (double) stats[ch].sumSquares;
+            }
+
+            const float rms = windowSamples > 0 ? (float) std::sqrt (window[ch].sumSquares / (double) windowSamples) : 0.0f;
+
+            published[ch].peak.store (window[ch].peak, std::memory_order_relaxed);
+            published[ch].rms.store (rms, std::memory_order_relaxed);
+        }
+    }
+
+    //==============================================================================
+    // Any thread.
+    int getNumChannels() const noexcept           { return publishedChannels.load (std::memory_order_relaxed); }
+
+    Reading getReading (int channel) const noexcept
+    {
+        if (channel < 0 || channel >= maxChannels)
+            return {};
+
+        return { published[channel].peak.load (std::memory_order_relaxed),
+                 published[channel].rms.load (std::memory_order_relaxed) };
+    }
+
+    // RMS over all published channels, i.e. the level of the whole output.
+    float getMixedRms() const noexcept
+    {
+        const int channels = getNumChannels();
+
+        if (channels == 0)
+            return 0.0f;
+
+        float sumOfSquares = 0.0f;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            const float rms = published[ch].rms.load (std::memory_order_relaxed);
+            sumOfSquares += rms * rms;
+        }
+
+        return std::sqrt (sumOfSquares / (float) channels);
+    }
+
+    // Reader side: call once after reading a frame's worth of values to start a new window.
+    void markRead() noexcept                      { readCount.fetch_add (1, std::memory_order_release); }
+
+private:
+    // Caps the window when nobody is reading (editor closed), roughly 20 s at 48 kHz.
+    static constexpr int64_t maxWindowSamples = 1 << 20;
+
+    struct alignas (64) PublishedChannel
+    {
+        std::atomic<float> peak { 0.0f };
+        std::atomic<float> rms { 0.0f };
+    };
+
+    struct WindowChannel
+    {
+        float peak = 0.0f;
+        double sumSquares = 0.0;
+    };
+
+    // Written by the audio thread, read by anyone.
+    PublishedChannel published[maxChannels];
+    std::atomic<int> publishedChannels { 0 };
+
+    // Written by the reader only, on its own cache line.
+    alignas (64) std::atomic<uint32_t> readCount { 0 };
+
+    // Audio thread only.
+    alignas (64) WindowChannel window[maxChannels];
+    int64_t windowSamples = 0;
+    uint32_t lastSeenReadCount = 0;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChannelLevelMeter.h"
+
+// A row of thin vertical meters, one per received channel: the bar shows RMS, the line on top of
+// it the peak since the previous frame. Levels are fed in from the editor on the display's
+// vertical blank; a channel is only repainted, on its own, when its bar or line moves a pixel.
+class ChannelMeterStrip : public juce::Component
+{
+public:
+    ChannelMeterStrip()
+    {
+        setOpaque(false);
+
+        for (int ch = 0; ch < ChannelLevelMeter::maxChannels; ++ch)
+            peaks[ch] = rmsLevels[ch] = minimumDb;
+    }
+
+    void setNumChannels(int newNumChannels)
+    {
+        newNumChannels = juce::jlimit(0, ChannelLevelMeter::maxChannels, newNumChannels);
+
+        if (newNumChannels != numChannels)
+        {
+            numChannels = newNumChannels;
+            repaint();
+        }
+    }
+
+    // Levels in dB, already floored at minimumDb.
+    void setLevels(int channel, float peakDb, float rmsDb)
+    {
+        if (channel < 0 || channel >= numChannels)
+            return;
+
+        const bool visible = pixelsFor(peakDb) != pixelsFor(peaks[channel])
+                             || pixelsFor(rmsDb) != pixelsFor(rmsLevels[channel])
+                             || (peakDb >= 0.0f) != (peaks[channel] >= 0.0f);   // Clip colour
+
+        peaks[channel] = peakDb;
+        rmsLevels[channel] = rmsDb;
+
+        if (visible)
+            repaint(getSlot(channel).getSmallestIntegerContainer().expanded(0, 2));   // The peak line overhangs
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        if (numChannels == 0)
+            return;
+
+        const float labelTop = (float) getHeight() - labelHeight;
+
+        g.setFont(labelFont);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const auto slot = getSlot(ch);
+
+            if (!g.clipRegionIntersects(slot.getSmallestIntegerContainer().withBottom(getHeight())))
+                continue;
+
+            g.setColour(juce::Colour::fromRGB(40, 40, 40));
+            g.fillRect(slot);
+
+            const float rmsHeight = slot.getHeight() * proportionOf(rmsLevels[ch]);
+            g.setColour(juce::Colours::goldenrod);
+            g.fillRect(slot.withTop(slot.getBottom() - rmsHeight));
+
+            const float peakY = slot.getBottom() - slot.getHeight() * proportionOf(peaks[ch]);
+            g.setColour(peaks[ch] >= 0.0f ? juce::Colours::red : juce::Colours::white);
+            g.fillRect(slot.withY(peakY).withHeight(1.5f));
+
+            g.setColour(juce::Colours::grey);
+            g.drawText(juce::String(ch + 1),
+                       juce::Rectangle<float>(slot.getX(), labelTop, slot.getWidth(), labelHeight),
+                       juce::Justification::centred, false);
+        }
+    }
+
+    static constexpr float minimumDb = -60.0f;
+
+private:
+    static constexpr float labelHeight = 14.0f;
+    const juce::Font labelFont { 10.0f };
+
+    static float proportionOf(float db)
+    {
+        return juce::jlimit(0.0f, 1.0f, (db - minimumDb) / -minimumDb);
+    }
+
+    // The bar area of one channel, above its label.
+    juce::Rectangle<float> getSlot(int channel) const
+    {
+        const auto area = getLocalBounds().toFloat().withTrimmedBottom(labelHeight);
+        const float slotWidth = area.getWidth() / (float) juce::jmax(1, numChannels);
+        return juce::Rectangle<float>(area.getX() + slotWidth * (float) channel, area.getY(), slotWidth, area.getHeight()).reduced(2.0f, 0.0f);
+    }
+
+    int pixelsFor(float db) const
+    {
+        return juce::roundToInt(proportionOf(db) * ((float) getHeight() - labelHeight));
+    }
+
+    int numChannels = 0;
+    float peaks[ChannelLevelMeter::maxChannels] {};
+    float rmsLevels[ChannelLevelMeter::maxChannels] {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelMeterStrip)
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Hands a connection object from the message thread to the audio thread without locks.
+//
+// The message thread builds a complete new connection and publish()es it; the previous one moves
+// to a retired list. The audio thread brackets each block with a ReadScope, which announces the
+// connection it is about to use in a single hazard slot and re-checks that it is still the
+// published one (if not it simply takes the newer one). A retired connection is destroyed by
+// collectRetired() only once the hazard slot no longer names it, i.e. once the audio thread has
+// acknowledged the switch or is between blocks. So unmapping always happens on the message
+// thread, after the audio thread has let go, and the audio thread never waits for anything.
+//
+// All stores/loads on `published` and `hazard` are sequentially consistent: the audio thread's
+// "store hazard, re-load published" and the message thread's "store published, load hazard" must
+// not be reordered against each other.
+template <typename ConnectionType>
+class ConnectionHandoff
+{
+public:
+    ConnectionHandoff() = default;
+
+    ~ConnectionHandoff()
+    {
+        // The owner guarantees the audio thread is gone by now.
+        published.store (nullptr);
+        current.reset();
+        retired.clear();
+    }
+
+    //==============================================================================
+    // Message thread.
+
+    // Makes `next` (which may be null) the connection the audio thread picks up on its next block.
+    void publish (std::unique_ptr<ConnectionType> next)
+    {
+        published.store (next.get());
+
+        if (current != nullptr)
+            retired.push_back (std::move (current));
+
+        current = std::move (next);
+        ++epoch;
+        collectRetired();
+    }
+
+    // Destroys retired connections the audio thread can no longer be using. Call regularly.
+    void collectRetired()
+    {
+        auto* inUse = hazard.load();
+
+        for (auto it = retired.begin(); it != retired.end();)
+        {
+            if (it->get() == inUse)
+                ++it;
+            else
+                it = retired.erase (it);
+        }
+    }
+
+    // The message thread's view: the most recently published connection.
+    ConnectionType* getCurrent() const noexcept      { return current.get(); }
+    bool hasRetiredConnections() const noexcept      { return ! retired.empty(); }
+    uint64_t getEpoch() const noexcept               { return epoch; }
+
+    //==============================================================================
+    // Audio thread: hold one of these for the duration of processBlock.
+    class ReadScope
+    {
+    public:
+        explicit ReadScope (ConnectionHandoff& h) noexcept : handoff (h)
+        {
+            auto* candidate = handoff.published.load();
+
+            for (;;)
+            {
+                handoff.hazard.store (candidate);
+                auto* confirmed = handoff.published.load();
+
+                if (confirmed == candidate)
+                    break;
+
+                candidate = confirmed;
+            }
+
+            connection = candidate;
+        }
+
+        ~ReadScope() noexcept
+        {
+            handoff.hazard.store (nullptr);
+        }
+
+        ConnectionType* get() const noexcept          { return connection; }
+        ConnectionType* operator->() const noexcept   { return connection; }
+        explicit operator bool() const noexcept       { return connection != nullptr; }
+
+    private:
+        ConnectionHandoff& handoff;
+        ConnectionType* connection = nullptr;
+
+        ReadScope (const ReadScope&) = delete;
+        ReadScope& operator= (const ReadScope&) = delete;
+    };
+
+private:
+    std::atomic<ConnectionType*> published { nullptr };
+    std::atomic<ConnectionType*> hazard { nullptr };
+
+    // Message thread only.
+    std::unique_ptr<ConnectionType> current;
+    std::vector<std::unique_ptr<ConnectionType>> retired;
+    uint64_t epoch = 0;
+};
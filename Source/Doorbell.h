@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "AddressWait.h"
+
+// A cross-process "something changed" counter that waiters can sleep on.
+//
+// The counter lives in shared memory. ring() bumps it and wakes every process blocked in wait();
+// wait() returns as soon as the counter differs from the value the caller last saw, or when the
+// timeout expires. The blocking is AddressWait's (a shared futex on Linux, os_sync_wait_on_address
+// on macOS 14.4+). Elsewhere wait() falls back to sleeping in short steps and comparing the
+// counter, which is still only a load per step, never a syscall that touches the segment.
+namespace Doorbell
+{
+    // Nudges waiters without changing the counter: they wake, see nothing changed and return false.
+    // Used to get a local waiter thread to notice it should exit.
+    inline void wakeAll (std::atomic<uint32_t>& counter) noexcept
+    {
+        AddressWait::wakeAll (counter);
+    }
+
+    inline void ring (std::atomic<uint32_t>& counter) noexcept
+    {
+        counter.fetch_add (1, std::memory_order_acq_rel);
+        wakeAll (counter);
+    }
+
+    // Blocks while the counter still equals lastSeen. Returns true if it changed.
+    inline bool wait (std::atomic<uint32_t>& counter, uint32_t lastSeen, int timeoutMs) noexcept
+    {
+        if (counter.load (std::memory_order_acquire) != lastSeen)
+            return true;
+
+        if (! AddressWait::wait (counter, lastSeen, (int64_t) timeoutMs * 1000000))
+        {
+            // No address wait available: short sleeps, so discovery still lands within a block or two.
+            constexpr int stepMs = 20;
+
+            for (int waited = 0; waited < timeoutMs; waited += stepMs)
+            {
+                if (counter.load (std::memory_order_acquire) != lastSeen)
+                    break;
+
+                std::this_thread::sleep_for (std::chrono::milliseconds (stepMs));
+            }
+        }
+
+        return counter.load (std::memory_order_acquire) != lastSeen;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// Keeps the shared ring's fill level near a target by nudging the resampling ratio.
+//
+// The fill level (frames written by the sender but not yet read) is smoothed over about a second
+// to hide the sender's block cadence, then fed to a PI controller:
+//     ratio = 1 + (error + integral / Ti) / (sampleRate * Tp)
+// With Ti = 4 Tp the loop is critically damped. In steady state the proportional term goes to
+// zero and the integral term equals the clock mismatch, which is what getDriftPpm() reports.
+// Tp is long on purpose: the fill is only sampled once per host block, so it carries up to a
+// block of phase-dependent error, and a slow loop turns that into a couple of hundred ppm of
+// ratio wobble at most instead of chasing it.
+// The correction is clamped to +-maxCorrection; the integrator stops while clamped.
+// Runs once per block on the audio thread, no allocation.
+class DriftController
+{
+public:
+    void prepare (double newSampleRate, double newTargetFill)
+    {
+        sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+        targetFill = newTargetFill;
+        reset();
+    }
+
+    void setTargetFill (double newTargetFill) noexcept  { targetFill = newTargetFill; }
+    double getTargetFill() const noexcept              { return targetFill; }
+
+    // Starts over from ratio 1 (after a resync or reconnect). Keeps the learned drift if asked,
+    // since the clocks usually haven't changed.
+    void reset (bool keepDriftEstimate = false) noexcept
+    {
+        if (! keepDriftEstimate)
+            integral = 0.0;
+
+        smoothedFill = -1.0;
+        ratio = 1.0 + integral / (integralTime * sampleRate * proportionalTime);
+    }
+
+    // Feed the fill level measured after this block's read. Returns the ratio for the next block
+    // (input frames consumed per output frame).
+    double update (double fill, int numSamples) noexcept
+    {
+        const double dt = (double) numSamples / sampleRate;
+
+        if (smoothedFill < 0.0)
+            smoothedFill = fill;
+        else
+            smoothedFill += (fill - smoothedFill) * (1.0 - std::exp (-dt / smoothingTime));
+
+        const double error = smoothedFill - targetFill;
+        const double scale = 1.0 / (sampleRate * proportionalTime);
+        const double unclamped = (error + (integral + error * dt) / integralTime) * scale;
+
+        // Conditional integration: don't wind up while the output is saturated.
+        if (std::abs (unclamped) < maxCorrection)
+            integral += error * dt;
+
+        const double correction = std::clamp ((error + integral / integralTime) * scale, -maxCorrection, maxCorrection);
+        ratio = 1.0 + correction;
+        return ratio;
+    }
+
+    double getRatio() const noexcept           { return ratio; }
+    double getSmoothedFill() const noexcept    { return smoothedFill < 0.0 ? 0.0 : smoothedFill; }
+
+    // Estimated sender/receiver clock mismatch in parts per million (positive: sender is faster).
+    double getDriftPpm() const noexcept
+    {
+        return integral / (integralTime * sampleRate * proportionalTime) * 1.0e6;
+    }
+
+    // Largest deviation from a ratio of 1 the controller will ask for (2000 ppm).
+    static constexpr double maxCorrection = 0.002;
+
+private:
+    static constexpr double proportionalTime = 8.0; // seconds
+    static constexpr double integralTime = 32.0;    // seconds, 4 x proportionalTime
+    static constexpr double smoothingTime = 1.0;    // seconds
+
+    double sampleRate = 48000.0;
+    double targetFill = 0.0;
+    double smoothedFill = -1.0;
+    double integral = 0.0;
+    double ratio = 1.0;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Small planar resampler for clock-drift correction.
+//
+// Ratios stay within a fraction of a percent of 1.0, so a 4-point Catmull-Rom interpolator is
+// plenty: it is exact at integer positions and continuous in value and slope across blocks.
+// New input frames are written straight into getInputPointers() (the ring de-interleave kernel
+// fills them), then process() produces the output block and keeps the few frames of history the
+// next block needs. All storage is sized in prepare(); process() never allocates.
+class FractionalResampler
+{
+public:
+    // Message thread. maxOutput is the largest block process() will be asked for.
+    void prepare (int numChannels, int maxOutput, double maxRatio)
+    {
+        channels = numChannels;
+        maxOutputFrames = maxOutput;
+        capacity = historyFrames + (int) std::ceil ((double) maxOutput * maxRatio) + 4;
+
+        storage.assign ((size_t) (channels * capacity), 0.0f);
+        channelPointers.resize ((size_t) channels);
+        inputPointers.resize ((size_t) channels);
+        positions.resize ((size_t) maxOutput);
+        fractions.resize ((size_t) maxOutput);
+
+        for (int ch = 0; ch < channels; ++ch)
+            channelPointers[(size_t) ch] = storage.data() + (size_t) (ch * capacity);
+
+        reset();
+    }
+
+    // Drops all history; the next output starts on the first new input frame.
+    void reset() noexcept
+    {
+        std::fill (storage.begin(), storage.end(), 0.0f);
+        validFrames = 1;  // One frame of silence stands in for the sample before the stream
+        position = 1.0;
+    }
+
+    int getNumChannels() const noexcept       { return channels; }
+    int getMaxOutputFrames() const noexcept   { return maxOutputFrames; }
+
+    // How many new input frames process() needs to produce numOutput frames at this ratio.
+    int getInputFramesNeeded (int numOutput, double ratio) const noexcept
+    {
+        const double lastPosition = position + (double) (numOutput - 1) * ratio;
+        const int needed = (int) lastPosition + 3 - validFrames;
+        return std::max (0, needed);
+    }
+
+    // The most output frames numInput new frames are enough for at this ratio, so a short read can
+    // still be played without breaking the interpolation.
+    int getOutputFramesFor (int numInput, double ratio) const noexcept
+    {
+        const double lastUsable = (double) (validFrames + numInput - 3);
+
+        if (lastUsable < position)
+            return 0;
+
+        int frames = (int) ((lastUsable - position) / ratio) + 1;
+
+        while (frames > 0 && getInputFramesNeeded (frames, ratio) > numInput)
+            --frames;
+
+        return frames;
+    }
+
+    // Where the next numNew input frames must be written before calling process().
+    float* const* getInputPointers() noexcept
+    {
+        for (int ch = 0; ch < channels; ++ch)
+            inputPointers[(size_t) ch] = channelPointers[(size_t) ch] + validFrames;
+
+        return inputPointers.data();
+    }
+
+    // numNew must be getInputFramesNeeded (numOutput, ratio) and numOutput <= getMaxOutputFrames().
+    // Only the first numOutputChannels channels are written to output.
+    void process (int numNew, float* const* output, int numOutputChannels, int numOutput, double ratio) noexcept
+    {
+        validFrames += numNew;
+
+        double pos = position;
+
+        for (int i = 0; i < numOutput; ++i)
+        {
+            const int index = (int) pos;
+            positions[(size_t) i] = index;
+            fractions[(size_t) i] = (float) (pos - (double) index);
+            pos += ratio;
+        }
+
+        for (int ch = 0; ch < std::min (channels, numOutputChannels); ++ch)
+        {
+            const float* x = channelPointers[(size_t) ch];
+            float* y = output[ch];
+
+            for (int i = 0; i < numOutput; ++i)
+            {
+                const int n = positions[(size_t) i];
+                const float t = fractions[(size_t) i];
+
+                const float xm1 = x[n - 1], x0 = x[n], x1 = x[n + 1], x2 = x[n + 2];
+
+                const float c1 = 0.5f * (x1 - xm1);
+                const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+                const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+                y[i] = ((c3 * t + c2) * t + c1) * t + x0;
+            }
+        }
+
+        // Keep one frame before the next output position onwards as history.
+        const int keepFrom = std::min ((int) pos - 1, validFrames);
+        const int keep = validFrames - keepFrom;
+
+        for (int ch = 0; ch < channels; ++ch)
+        {
+            float* x = channelPointers[(size_t) ch];
+            std::copy (x + keepFrom, x + validFrames, x);
+        }
+
+        validFrames = keep;
+        position = pos - (double) keepFrom;
+    }
+
+private:
+    static constexpr int historyFrames = 4;
+
+    int channels = 0;
+    int capacity = 0;
+    int maxOutputFrames = 0;
+    int validFrames = 1;
+    double position = 1.0;
+
+    std::vector<float> storage;
+    std::vector<float*> channelPointers, inputPointers;
+    std::vector<int> positions;
+    std::vector<float> fractions;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "AddressWait.h"
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#endif
+
+// Waits for a sender's writeIndex to reach a given frame. Only for offline rendering, where the
+// host waits for processBlock rather than the other way round; never call it on a live block.
+//
+// Spins for a few microseconds first, since a sender rendering as fast as it can usually
+// publishes the next block within that. After that it blocks in steps of blockStepUs, each an
+// AddressWait on writeIndex. A sender that calls wake() after publishing ends the wait straight
+// away. Any other sender is noticed when the step times out. Where there is no address wait each
+// step is a plain sleep. Once the spin is over, nothing here busy-waits.
+//
+// Standard library and OS calls only, so the sender can share it.
+namespace FrameWaiter
+{
+    static constexpr int spinIterations = 4000;
+    static constexpr int blockStepUs = 250;
+
+    inline void pause() noexcept
+    {
+       #if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+        _mm_pause();
+       #elif defined (__aarch64__) || defined (__arm__)
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    // Sender side, after storing writeIndex: wakes receivers blocked in waitFor(). One syscall,
+    // whether or not anyone waits.
+    inline void wake (std::atomic<uint64_t>& writeIndex) noexcept
+    {
+        AddressWait::wakeAll (writeIndex);
+    }
+
+    // Returns the first writeIndex seen at or past `frame`, or the last one seen when timeoutMs
+    // runs out. `load` reads the index. `word` is the index itself when it is a 64-bit atomic
+    // that can be waited on, or null to just sleep between loads (e.g. the legacy layout).
+    template <typename LoadFunction>
+    uint64_t waitFor (const std::atomic<uint64_t>* word, LoadFunction&& load, uint64_t frame, double timeoutMs) noexcept
+    {
+        uint64_t current = load();
+
+        for (int i = 0; i < spinIterations && current < frame; ++i)
+        {
+            pause();
+            current = load();
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli> (timeoutMs);
+
+        while (current < frame && std::chrono::steady_clock::now() < deadline)
+        {
+            if (word == nullptr || ! AddressWait::wait (*word, current, (int64_t) blockStepUs * 1000))
+                std::this_thread::sleep_for (std::chrono::microseconds (blockStepUs));
+
+            current = load();
+        }
+
+        return current;
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// Decides how many frames the receiver keeps buffered in the ring ahead of its read cursor.
+//
+// The depth is either fixed by the user (in samples or milliseconds), or tuned automatically:
+// start from a small floor, grow by half on every underrun, and after a long stretch without
+// underruns shrink by an eighth, so the buffer settles just above the jitter the sender actually
+// shows. The drift controller then steers the ring towards this depth, and the processor reports
+// it to the host as the plugin's latency.
+//
+// Settings are written from the message thread and picked up by the audio thread; the tuning
+// state itself is audio-thread only. No allocation, no locks.
+class JitterBuffer
+{
+public:
+    enum class Mode { automatic, fixedSamples, fixedMilliseconds };
+
+    //==============================================================================
+    // Message thread.
+    void setAutomatic() noexcept                        { mode.store (Mode::automatic); }
+    void setFixedSamples (double samples) noexcept      { fixedAmount.store (samples); mode.store (Mode::fixedSamples); }
+    void setFixedMilliseconds (double ms) noexcept      { fixedAmount.store (ms); mode.store (Mode::fixedMilliseconds); }
+
+    Mode getMode() const noexcept                       { return mode.load(); }
+    double getFixedAmount() const noexcept              { return fixedAmount.load(); }
+
+    //==============================================================================
+    // Audio thread (or before playback starts). maxDepth bounds any setting, normally a fraction
+    // of the ring so the sender always has room to write.
+    void prepare (double newSampleRate, int newBlockSize, double newMaxDepth) noexcept
+    {
+        sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+        frameRate = sampleRate;
+        blockSize = std::max (1, newBlockSize);
+        maxDepth = std::max (minimumDepth, newMaxDepth);
+        autoDepth = std::min (maxDepth, std::max (initialAutoDepth, (double) blockSize));
+        secondsSinceUnderrun = 0.0;
+    }
+
+    // A connection whose ring is a different size moves the ceiling.
+    void setMaxDepth (double newMaxDepth) noexcept
+    {
+        maxDepth = std::max (minimumDepth, newMaxDepth);
+        autoDepth = std::min (maxDepth, autoDepth);
+    }
+
+    // Rate of the ring frames the depth is counted in, when the sender runs at another rate than
+    // the host (see PolyphaseResampler). prepare() resets it to the host rate.
+    void setFrameRate (double framesPerSecond) noexcept
+    {
+        frameRate = framesPerSecond > 0.0 ? framesPerSecond : sampleRate;
+    }
+
+    // The depth to steer towards for the coming block.
+    double getTargetDepth() const noexcept
+    {
+        double depth = autoDepth;
+
+        switch (mode.load (std::memory_order_relaxed))
+        {
+            case Mode::fixedSamples:        depth = fixedAmount.load (std::memory_order_relaxed); break;
+            case Mode::fixedMilliseconds:   depth = fixedAmount.load (std::memory_order_relaxed) * frameRate / 1000.0; break;
+            case Mode::automatic:           break;
+        }
+
+        return std::clamp (std::round (depth), minimumDepth, maxDepth);
+    }
+
+    void noteUnderrun() noexcept
+    {
+        secondsSinceUnderrun = 0.0;
+
+        if (mode.load (std::memory_order_relaxed) == Mode::automatic)
+            autoDepth = std::min (maxDepth, autoDepth + std::max (autoDepth * 0.5, (double) blockSize * 0.5));
+    }
+
+    void notePlayed (int numSamples) noexcept
+    {
+        secondsSinceUnderrun += (double) numSamples / sampleRate;
+
+        if (secondsSinceUnderrun < relaxAfterSeconds || mode.load (std::memory_order_relaxed) != Mode::automatic)
+            return;
+
+        secondsSinceUnderrun = 0.0;
+        autoDepth = std::max (minimumDepth, autoDepth - std::max (autoDepth / 8.0, 16.0));
+    }
+
+    static double toMilliseconds (double frames, double rate) noexcept   { return rate > 0.0 ? frames * 1000.0 / rate : 0.0; }
+
+private:
+    static constexpr double minimumDepth = 32.0;       // frames
+    static constexpr double initialAutoDepth = 128.0;  // frames
+    static constexpr double relaxAfterSeconds = 30.0;
+
+    std::atomic<Mode> mode { Mode::automatic };
+    std::atomic<double> fixedAmount { 512.0 };
+
+    double sampleRate = 48000.0;
+    double frameRate = 48000.0;
+    int blockSize = 512;
+    double maxDepth = 8192.0;
+    double autoDepth = initialAutoDepth;
+    double secondsSinceUnderrun = 0.0;
+};
@@ -13,49 +13,367 @@ AudioReceiverAudioProcessorEditor::AudioReceiverAudioProcessorEditor (AudioRecei
     statusLabel.setFont(juce::Font(16.0f));
     statusLabel.setText("Connecting...", juce::dontSendNotification);
     statusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    statusLabel.addMouseListener(this, false);
     
+    // Stream selector, filled from the senders currently announced in the directory. Editable, so
+    // an unannounced segment name or "udp:<port>" can be typed in.
+    addAndMakeVisible(streamSelector);
+    streamSelector.setTextWhenNothingSelected("Select stream");
+    streamSelector.setEditableText(true);
+    streamSelector.onChange = [this]
+    {
+        const int index = streamSelector.getSelectedId() - 1;
+
+        if (index >= 0 && index < (int) streamChoices.size())
+            audioProcessor.setStreamName(streamChoices[(size_t) index]);
+        else if (streamSelector.getSelectedId() == 0 && streamSelector.getText().isNotEmpty())
+            audioProcessor.setStreamName(streamSelector.getText());
+    };
+    refreshStreamList();
+
+    // Jitter buffer depth: automatic, or a fixed amount in samples or milliseconds
+    addAndMakeVisible(bufferSelector);
+    bufferSelector.setTooltip("Receive buffer depth (reported to the host as latency)");
+
+    for (size_t i = 0; i < bufferPresets.size(); ++i)
+        bufferSelector.addItem(bufferPresets[i].text, (int) i + 1);
+
+    bufferSelector.onChange = [this]
+    {
+        const int index = bufferSelector.getSelectedId() - 1;
+
+        if (index < 0 || index >= (int) bufferPresets.size())
+            return;
+
+        const auto& preset = bufferPresets[(size_t) index];
+        auto& jitterBuffer = audioProcessor.getJitterBuffer();
+
+        if (preset.mode == JitterBuffer::Mode::fixedSamples)
+            jitterBuffer.setFixedSamples(preset.amount);
+        else if (preset.mode == JitterBuffer::Mode::fixedMilliseconds)
+            jitterBuffer.setFixedMilliseconds(preset.amount);
+        else
+            jitterBuffer.setAutomatic();
+    };
+    showBufferSetting();
+
     //Meter:
     addAndMakeVisible(audioMeter);
     audioMeter.setGainEnabled(true);  // Enable gain control
+    gainParameter = audioProcessor.getParameters().getParameter(AudioReceiverAudioProcessor::gainParameterId);
+    showGain();
     audioMeter.getSlider().addListener(this);
+    addAndMakeVisible(channelMeters);
+
+    // Telemetry: toggled with the Stats button, takes the channel meters' place
+    addAndMakeVisible(statsButton);
+    statsButton.setClickingTogglesState(true);
+    statsButton.onClick = [this]
+    {
+        if (statsButton.getToggleState())
+            routeButton.setToggleState(false, juce::dontSendNotification);
+
+        updatePanels();
+    };
+
+    addAndMakeVisible(routeButton);
+    routeButton.setClickingTogglesState(true);
+    routeButton.onClick = [this]
+    {
+        if (routeButton.getToggleState())
+            statsButton.setToggleState(false, juce::dontSendNotification);
+
+        updatePanels();
+    };
+
+    addChildComponent(routingGrid);
+
+    addChildComponent(telemetryView);
+    telemetryView.onDump = [this]
+    {
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                        .getNonexistentChildFile("AudioReceiverTelemetry", ".txt");
+
+        telemetryView.setStatusText(audioProcessor.getTelemetry().dumpToFile(file) ? "Saved " + file.getFileName()
+                                                                                   : "Couldn't write " + file.getFullPathName());
+    };
+
+    telemetryView.setCapturing(audioProcessor.getCaptureTap().isCapturing());
+    telemetryView.onCapture = [this](bool shouldCapture)
+    {
+        if (!shouldCapture)
+        {
+            const auto summary = audioProcessor.getCaptureTap().stop();
+            telemetryView.setStatusText("Saved " + summary.describe(audioProcessor.getSampleRate()));
+            return;
+        }
+
+        auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                        .getNonexistentChildFile("AudioReceiverCapture", ".wav");
+        juce::String error;
+
+        if (!audioProcessor.startCapture(file, error))
+        {
+            telemetryView.setCapturing(false);
+            telemetryView.setStatusText("Couldn't capture: " + error);
+        }
+    };
 
     
     // Start the timer to update status
 //    startTimer(500); // Update every 500ms
     
-    startTimerHz(24);
-    
+    startTimerHz(timerHz);
+
+    // The cached background covers every pixel, so nothing behind the editor needs repainting.
+    setOpaque(true);
     setSize(400, 300);
 }
 
 
+void AudioReceiverAudioProcessorEditor::refreshStreamList()
+{
+    // Live streams plus whatever we're set to, so the current choice is always visible.
+    std::vector<std::string> names;
+    std::vector<juce::String> itemTexts;
+    const auto current = audioProcessor.getStreamName().toStdString();
+
+    for (const auto& stream : audioProcessor.getAvailableStreams())
+    {
+        names.push_back(stream.name);
+        itemTexts.push_back(juce::String(stream.name) + (stream.label.empty() ? "" : "  (" + stream.label + ")"));
+    }
+
+    if (std::find(names.begin(), names.end(), current) == names.end())
+    {
+        names.push_back(current);
+        uint16_t port = 0;
+        itemTexts.push_back(juce::String(current) + (UdpReceiver::parseStreamName(current, port) ? "  (network)" : "  (offline)"));
+    }
+
+    // Don't rebuild an unchanged list; that would close the popup under the user's mouse.
+    if (names != streamChoices)
+    {
+        streamChoices = names;
+        streamSelector.clear(juce::dontSendNotification);
+
+        for (size_t i = 0; i < itemTexts.size(); ++i)
+            streamSelector.addItem(itemTexts[i], (int) i + 1);
+    }
+
+    const auto selected = std::find(streamChoices.begin(), streamChoices.end(), current);
+    const int selectedId = (int) (selected - streamChoices.begin()) + 1;
+
+    if (streamSelector.getSelectedId() != selectedId)
+        streamSelector.setSelectedId(selectedId, juce::dontSendNotification);
+}
+
+void AudioReceiverAudioProcessorEditor::updatePanels()
+{
+    const bool showStats = statsButton.getToggleState();
+    const bool showRouting = routeButton.getToggleState();
+
+    telemetryView.setVisible(showStats);
+    routingGrid.setVisible(showRouting);
+    channelMeters.setVisible(!showStats && !showRouting);
+    ticksUntilTelemetryRefresh = 0;
+}
+
+void AudioReceiverAudioProcessorEditor::showBufferSetting()
+{
+    const auto& jitterBuffer = audioProcessor.getJitterBuffer();
+    const auto mode = jitterBuffer.getMode();
+    const double amount = jitterBuffer.getFixedAmount();
+
+    for (size_t i = 0; i < bufferPresets.size(); ++i)
+    {
+        const auto& preset = bufferPresets[i];
+
+        if (preset.mode == mode && (mode == JitterBuffer::Mode::automatic || preset.amount == amount))
+        {
+            bufferSelector.setSelectedId((int) i + 1, juce::dontSendNotification);
+            return;
+        }
+    }
+
+    // A depth restored from state that isn't one of the presets
+    bufferSelector.setText(juce::String(amount) + (mode == JitterBuffer::Mode::fixedMilliseconds ? " ms" : " samples"),
+                           juce::dontSendNotification);
+}
+
 void AudioReceiverAudioProcessorEditor::timerCallback()
 {
+    const EditorLoad::Scope timing(editorLoad);
+
+    // Re-list as soon as a sender comes or goes; the slow refresh only catches senders that
+    // died without withdrawing (their entries go stale rather than ringing the doorbell).
+    const uint32_t streamListChanges = audioProcessor.getStreamListChangeCount();
+
+    if (streamListChanges != lastStreamListChanges || --ticksUntilStreamRefresh <= 0)
+    {
+        refreshStreamList();
+        lastStreamListChanges = streamListChanges;
+        ticksUntilStreamRefresh = timerHz;
+    }
+
     if (audioProcessor.isConnectionActive())
     {
-        statusLabel.setText("Connected to AudioSender", juce::dontSendNotification);
-        statusLabel.setColour(juce::Label::textColourId, juce::Colours::lime);
+        const auto& metrics = audioProcessor.getReceiverMetrics();
+        const auto encoding = (SampleFormat::Encoding) metrics.ringEncoding.load();
+        const juce::String format = encoding == SampleFormat::float32 ? juce::String() : ", " + juce::String(SampleFormat::getName(encoding));
+
+        juce::String network;
+
+        if (metrics.conversionRatio.load() != 1.0)
+            network << ", " << juce::String(metrics.senderSampleRate.load() / 1000.0, 1) << " kHz converted";
+
+        if (auto* udp = audioProcessor.getUdpStats())
+            network << ", " << (juce::int64) udp->lostPackets.load() << " lost";
+
+        // Orange when a mapping step we asked for didn't work (details in the click menu).
+        showStatus("Connected to AudioSender  (" + juce::String(metrics.latencyMs.load(), 1) + " ms" + format + network + ")",
+                   audioProcessor.getMappingReport().anyFailed() ? juce::Colours::orange : juce::Colours::lime);
     }
     else if (audioProcessor.isMemoryInitializedAndActive())
     {
-        statusLabel.setText("Sender Not Active", juce::dontSendNotification);
-        statusLabel.setColour(juce::Label::textColourId, juce::Colours::red);
+        showStatus("Sender Not Active", juce::Colours::red);
     }
     else
     {
-        statusLabel.setText("Not Connected", juce::dontSendNotification);
-        statusLabel.setColour(juce::Label::textColourId, juce::Colours::red);
+        const auto error = audioProcessor.getConnectionError();
+        showStatus(error.isEmpty() ? juce::String("Not Connected") : "Not Connected (" + error + ")", juce::Colours::red);
     }
     
+    routingGrid.setNumSources(audioProcessor.getNumSharedChannels());
+    const auto outputLayout = audioProcessor.describeOutputLayout();
+    routingGrid.setNumOutputs(outputLayout.numRows);
+    routingGrid.setPlayedOutputs(outputLayout.getPlayedRows());
+
+    if (editorLoad.update())
+        telemetryView.setEditorLoad(editorLoad.msPerSecond);
+
+    if (telemetryView.isVisible() && --ticksUntilTelemetryRefresh <= 0)
     {
-        float level;
-        {
-            const juce::ScopedLock sl(audioProcessor.levelLock);
-            level = audioProcessor.currentLevel;
-        }
+        telemetryView.setSnapshot(audioProcessor.getTelemetry().getSnapshot());
+        ticksUntilTelemetryRefresh = timerHz / 2;
 
-        audioMeter.setLevel(level);
+        // Overflows show up here as they happen, not only when the capture is stopped.
+        if (audioProcessor.getCaptureTap().isCapturing())
+            telemetryView.setStatusText("Capturing " + audioProcessor.getCaptureTap().getProgress().describe(audioProcessor.getSampleRate()));
     }
+
+    // Host automation moves the fader, unless the user is holding it.
+    if (!draggingGain)
+        showGain();
+}
+
+// Label::setText compares, but setColour and building the attributed text don't come free; only
+// touch the label when what it shows actually changes.
+void AudioReceiverAudioProcessorEditor::showStatus(const juce::String& text, juce::Colour colour)
+{
+    if (text != statusLabel.getText())
+        statusLabel.setText(text, juce::dontSendNotification);
+
+    if (colour != statusLabel.findColour(juce::Label::textColourId))
+        statusLabel.setColour(juce::Label::textColourId, colour);
+}
+
+// Called on the display's vertical blank while the editor is showing.
+void AudioReceiverAudioProcessorEditor::updateMeters()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    // Refresh rates above meterRefreshHz skip frames; a little slack keeps a 60 Hz display from
+    // beating against the limit.
+    if (now - lastMeterUpdateMs < 1000.0 / meterRefreshHz - 2.0)
+        return;
+
+    const EditorLoad::Scope timing(editorLoad);
+    lastMeterUpdateMs = now;
+
+    // Lock-free read of the processor's meters; markRead() starts the next measurement window.
+    auto& meter = audioProcessor.getLevelMeter();
+    const int numChannels = meter.getNumChannels();
+    const float floorDb = ChannelMeterStrip::minimumDb;
+
+    channelMeters.setNumChannels(numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto reading = meter.getReading(ch);
+        channelMeters.setLevels(ch,
+                                juce::Decibels::gainToDecibels(reading.peak, floorDb),
+                                juce::Decibels::gainToDecibels(reading.rms, floorDb));
+    }
+
+    // The fader's meter repaints on every call, so leave it alone for changes nobody can see.
+    const float mixedRmsDb = juce::Decibels::gainToDecibels(meter.getMixedRms(), floorDb);
+
+    if (std::abs(mixedRmsDb - lastMixedRmsDb) >= 0.1f)
+    {
+        audioMeter.setLevel(mixedRmsDb);
+        lastMixedRmsDb = mixedRmsDb;
+    }
+
+    meter.markRead();
+}
+
+void AudioReceiverAudioProcessorEditor::mouseUp(const juce::MouseEvent& event)
+{
+    if (event.eventComponent == &statusLabel)
+        showSettingsMenu();
+}
+
+void AudioReceiverAudioProcessorEditor::showSettingsMenu()
+{
+    const auto options = audioProcessor.getMappingOptions();
+
+    auto toggle = [this](bool SharedConnection::MappingOptions::* option)
+    {
+        auto changed = audioProcessor.getMappingOptions();
+        changed.*option = !(changed.*option);
+        audioProcessor.setMappingOptions(changed);
+    };
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Shared memory mapping");
+    menu.addItem("Pre-fault pages on connect", true, options.prefault, [toggle] { toggle(&SharedConnection::MappingOptions::prefault); });
+    menu.addItem("Lock pages in RAM", true, options.lockPages, [toggle] { toggle(&SharedConnection::MappingOptions::lockPages); });
+    menu.addItem("Use huge pages", true, options.hugePages, [toggle] { toggle(&SharedConnection::MappingOptions::hugePages); });
+
+    if (audioProcessor.isMemoryInitializedAndActive())
+    {
+        menu.addSeparator();
+
+        for (const auto& line : audioProcessor.getMappingReport().describe())
+            menu.addItem(line, false, false, nullptr);
+    }
+
+    using Alignment = AudioReceiverAudioProcessor::Alignment;
+    const auto alignment = audioProcessor.getAlignment();
+    auto align = [this](Alignment newAlignment) { audioProcessor.setAlignment(newAlignment); };
+
+    menu.addSectionHeader("Line up with");
+    menu.addItem("Ring fill", true, alignment == Alignment::ringFill, [align] { align(Alignment::ringFill); });
+    menu.addItem("Sender clock", true, alignment == Alignment::senderClock, [align] { align(Alignment::senderClock); });
+    menu.addItem("Host transport", true, alignment == Alignment::hostTransport, [align] { align(Alignment::hostTransport); });
+
+    // What the last block actually followed, and the offsets the anchors show.
+    if (audioProcessor.isConnectionActive())
+    {
+        const auto& metrics = audioProcessor.getReceiverMetrics();
+        static const char* const followed[] = { "ring fill (no time anchors)", "sender clock", "host transport" };
+        menu.addSeparator();
+        menu.addItem("Following " + juce::String(followed[juce::jmin(2u, metrics.alignedTo.load())]), false, false, nullptr);
+
+        if (const double offset = metrics.timelineOffsetMs.load(); offset != 0.0)
+            menu.addItem(juce::String(offset, 2) + " ms behind the sender's clock", false, false, nullptr);
+
+        if (const double offset = metrics.transportOffsetMs.load(); offset != 0.0)
+            menu.addItem(juce::String(offset, 2) + " ms behind our playhead", false, false, nullptr);
+    }
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&statusLabel));
 }
 
 AudioReceiverAudioProcessorEditor::~AudioReceiverAudioProcessorEditor()
@@ -68,15 +386,68 @@ AudioReceiverAudioProcessorEditor::~AudioReceiverAudioProcessorEditor()
 //Meter:
 void AudioReceiverAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
 {
-    if (slider == &audioMeter.getSlider())
+    if (slider == &audioMeter.getSlider() && gainParameter != nullptr)
+    {
+        // Pass the fader's gain to the processor's parameter, which processBlock ramps towards
+        const float gainDb = juce::Decibels::gainToDecibels(audioMeter.getGainLinear(), AudioReceiverAudioProcessor::minGainDb);
+        gainParameter->setValueNotifyingHost(gainParameter->convertTo0to1(gainDb));
+    }
+}
+
+void AudioReceiverAudioProcessorEditor::sliderDragStarted(juce::Slider* slider)
+{
+    if (slider == &audioMeter.getSlider() && gainParameter != nullptr)
+    {
+        draggingGain = true;
+        gainParameter->beginChangeGesture();
+    }
+}
+
+void AudioReceiverAudioProcessorEditor::sliderDragEnded(juce::Slider* slider)
+{
+    if (slider == &audioMeter.getSlider() && gainParameter != nullptr)
     {
-        // Pass slider value to processor (linear gain)
-        audioProcessor.gain = audioMeter.getGainLinear();
+        gainParameter->endChangeGesture();
+        draggingGain = false;
     }
 }
 
+// The fader is in dB, like the parameter.
+void AudioReceiverAudioProcessorEditor::showGain()
+{
+    if (gainParameter == nullptr)
+        return;
+
+    const double gainDb = gainParameter->convertFrom0to1(gainParameter->getValue());
+
+    if (audioMeter.getSlider().getValue() != gainDb)
+        audioMeter.getSlider().setValue(gainDb, juce::dontSendNotification);
+}
+
 void AudioReceiverAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    const EditorLoad::Scope timing(editorLoad);
+
+    // Drawn at the display's pixel scale so the cached text stays as sharp as drawing it directly.
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (backgroundImage.isNull() || scale != backgroundScale)
+        renderBackground(scale);
+
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+}
+
+void AudioReceiverAudioProcessorEditor::renderBackground(float scale)
+{
+    backgroundScale = scale;
+    backgroundImage = juce::Image(juce::Image::RGB,
+                                  juce::jmax(1, juce::roundToInt((float) getWidth() * scale)),
+                                  juce::jmax(1, juce::roundToInt((float) getHeight() * scale)),
+                                  false);
+
+    juce::Graphics g(backgroundImage);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
     // Gradient background (same as TransportSender)
     juce::ColourGradient backgroundGradient(
         juce::Colour::fromRGB(30, 30, 30), // Dark grey top
@@ -134,12 +505,29 @@ void AudioReceiverAudioProcessorEditor::resized()
 {
     
     
+    // The background is redrawn for the new size on the next paint
+    backgroundImage = {};
+
     // Position the status label in the upper part of the UI
     juce::Rectangle<int> area = getLocalBounds();
     area.removeFromTop(70); // Space for the title
     statusLabel.setBounds(area.removeFromTop(40).reduced(20, 0));
+    auto selectorRow = area.removeFromTop(26).reduced(20, 0);
+    routeButton.setBounds(selectorRow.removeFromRight(50));
+    selectorRow.removeFromRight(4);
+    statsButton.setBounds(selectorRow.removeFromRight(50));
+    selectorRow.removeFromRight(8);
+    bufferSelector.setBounds(selectorRow.removeFromRight(110));
+    selectorRow.removeFromRight(8);
+    streamSelector.setBounds(selectorRow);
     
     //Meter:
     // Place the audio meter on the left side
     audioMeter.setBounds(area.removeFromRight(80));
+
+    // Per-channel meters fill the space left of the fader, above the footer
+    area.removeFromBottom(40);
+    channelMeters.setBounds(area.reduced(20, 10));
+    telemetryView.setBounds(area.reduced(20, 10));
+    routingGrid.setBounds(area.reduced(20, 10));
 }
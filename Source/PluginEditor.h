@@ -5,6 +5,9 @@
 
 #include "AudioMeterFader.h"
 #include "AudioLevelUtils.h"
+#include "ChannelMeterStrip.h"
+#include "TelemetryView.h"
+#include "RoutingGrid.h"
 
 //==============================================================================
 /**
@@ -20,16 +23,121 @@ public:
     void resized() override;
     //==============================================================================
     void timerCallback() override;
+    void mouseUp(const juce::MouseEvent& event) override;
 
 private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     AudioReceiverAudioProcessor& audioProcessor;
     
-    juce::Label statusLabel;
+    juce::Label statusLabel;   // Click for the mapping and alignment options and how they went
+    void showSettingsMenu();
+    void showStatus(const juce::String& text, juce::Colour colour);
+
+    // Background, title and footer, drawn once per size (and display scale) and then blitted.
+    juce::Image backgroundImage;
+    float backgroundScale = 0.0f;
+    void renderBackground(float scale);
+
+    // Status, stream list and telemetry run off a slow timer; the meters follow the display's
+    // vertical blank, throttled to meterRefreshHz, so their repaints land on frames that are drawn.
+    static constexpr int timerHz = 8;
+    static constexpr double meterRefreshHz = 30.0;
+    double lastMeterUpdateMs = 0.0;
+    float lastMixedRmsDb = 0.0f;
+    void updateMeters();
+
+    // Message-thread time spent in this editor's timer, vblank and paint callbacks, per second of
+    // wall time; shown in the Stats panel so sessions with many instances can be checked.
+    struct EditorLoad
+    {
+        struct Scope
+        {
+            explicit Scope(EditorLoad& l) : load(l), start(juce::Time::getHighResolutionTicks()) {}
+            ~Scope() { load.busyTicks += juce::Time::getHighResolutionTicks() - start; }
+
+            EditorLoad& load;
+            const juce::int64 start;
+        };
+
+        // Closes the measurement window once a second has passed; true when a new figure is ready.
+        bool update()
+        {
+            const auto now = juce::Time::getHighResolutionTicks();
+            const double elapsed = juce::Time::highResolutionTicksToSeconds(now - windowStart);
+
+            if (elapsed < 1.0)
+                return false;
+
+            msPerSecond = juce::Time::highResolutionTicksToSeconds(busyTicks) * 1000.0 / elapsed;
+            busyTicks = 0;
+            windowStart = now;
+            return true;
+        }
+
+        juce::int64 busyTicks = 0;
+        juce::int64 windowStart = juce::Time::getHighResolutionTicks();
+        double msPerSecond = 0.0;
+    };
+
+    EditorLoad editorLoad;
+
+    // Picks the sender stream from the discovery directory
+    juce::ComboBox streamSelector;
+    std::vector<std::string> streamChoices;
+    int ticksUntilStreamRefresh = 0;
+    uint32_t lastStreamListChanges = 0;
+    void refreshStreamList();
+
+    // Jitter buffer depth presets
+    struct BufferPreset
+    {
+        const char* text;
+        JitterBuffer::Mode mode;
+        double amount;
+    };
+
+    static constexpr std::array<BufferPreset, 10> bufferPresets {{
+        { "Auto",          JitterBuffer::Mode::automatic,         0.0 },
+        { "128 samples",   JitterBuffer::Mode::fixedSamples,      128.0 },
+        { "256 samples",   JitterBuffer::Mode::fixedSamples,      256.0 },
+        { "512 samples",   JitterBuffer::Mode::fixedSamples,      512.0 },
+        { "1024 samples",  JitterBuffer::Mode::fixedSamples,      1024.0 },
+        { "2048 samples",  JitterBuffer::Mode::fixedSamples,      2048.0 },
+        { "5 ms",          JitterBuffer::Mode::fixedMilliseconds, 5.0 },
+        { "10 ms",         JitterBuffer::Mode::fixedMilliseconds, 10.0 },
+        { "20 ms",         JitterBuffer::Mode::fixedMilliseconds, 20.0 },
+        { "50 ms",         JitterBuffer::Mode::fixedMilliseconds, 50.0 },
+    }};
+
+    juce::ComboBox bufferSelector;
+    void showBufferSetting();
     
+    // The fader drives the processor's gain parameter (in dB) as one host gesture per drag, and
+    // follows the parameter when the host automates it.
     void sliderValueChanged(juce::Slider* slider) override;
+    void sliderDragStarted(juce::Slider* slider) override;
+    void sliderDragEnded(juce::Slider* slider) override;
+    void showGain();
+    juce::RangedAudioParameter* gainParameter = nullptr;
+    bool draggingGain = false;
     AudioMeterFader audioMeter;
+    ChannelMeterStrip channelMeters;
+
+    // Telemetry histograms and the routing grid, each shown in place of the channel meters
+    juce::TextButton statsButton { "Stats" };
+    TelemetryView telemetryView;
+    int ticksUntilTelemetryRefresh = 0;
+
+    juce::TextButton routeButton { "Route" };
+    RoutingGrid routingGrid { audioProcessor.getRoutingMatrix(),
+                              audioProcessor.getNumSharedChannels(),
+                              AudioReceiverAudioProcessor::getNumDummyChannels() };
+
+    void updatePanels();
+
+    // Last, so it stops calling back before the components it updates go away.
+    juce::VBlankAttachment meterRefresh { this, [this] { updateMeters(); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioReceiverAudioProcessorEditor)
 };
@@ -1,6 +1,16 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "SharedMemoryManager.h"
+#include "RingDeinterleave.h"
+
+namespace
+{
+    // The gain parameter in dB as a linear factor; the bottom of its range is silence.
+    float gainToLinear(float decibels)
+    {
+        return juce::Decibels::decibelsToGain(decibels, AudioReceiverAudioProcessor::minGainDb);
+    }
+}
 
 //==============================================================================
 AudioReceiverAudioProcessor::AudioReceiverAudioProcessor()
@@ -21,9 +31,23 @@ AudioReceiverAudioProcessor::AudioReceiverAudioProcessor()
                        )
 #endif
 {
+    gainParameter = parameters.getRawParameterValue(gainParameterId);
+    driftCompensationParameter = parameters.getRawParameterValue(driftCompensationParameterId);
+
     // Initialize flag to false
     canWriteToSharedMemory = false;
 
+    // Default routing: the shared channels after the dummies, in order
+    routingMatrix.setOffsetMap(dummyChannels, totalSharedChannels - dummyChannels);
+
+    // Map the stream directory up front so the editor can list senders before we connect
+    if (!streamDirectory.attach())
+        DBG("Stream directory unavailable: " + juce::String(strerror(errno)));
+
+    streamWatcher.onStreamsChanged = [this] { handleStreamsChanged(); };
+    streamWatcher.start();
+    telemetryCollector.start();
+
     //Try initial connection
     //initializeConnection();
     //^Cubase might instantiate the plugin before the audio thread is active. //Deferring shared memory setup until prepareToPlay():
@@ -34,6 +58,33 @@ AudioReceiverAudioProcessor::AudioReceiverAudioProcessor()
     
 }
 
+juce::AudioProcessorValueTreeState::ParameterLayout AudioReceiverAudioProcessor::createParameterLayout()
+{
+    // Skewed so the top half of the travel covers the last 12 dB below unity.
+    juce::NormalisableRange<float> gainRange(minGainDb, maxGainDb, 0.1f);
+    gainRange.setSkewForCentre(-12.0f);
+
+    auto gainAttributes = juce::AudioParameterFloatAttributes()
+                              .withLabel("dB")
+                              .withStringFromValueFunction([](float value, int)
+                              {
+                                  return value <= minGainDb ? juce::String("-inf") : juce::String(value, 1);
+                              });
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID(gainParameterId, 1), "Gain",
+                                                           gainRange, 0.0f, gainAttributes));
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID(driftCompensationParameterId, 1),
+                                                          "Drift Compensation", true));
+    return layout;
+}
+
+void AudioReceiverAudioProcessor::setDriftCompensationEnabled(bool shouldBeEnabled)
+{
+    if (auto* parameter = parameters.getParameter(driftCompensationParameterId))
+        parameter->setValueNotifyingHost(shouldBeEnabled ? 1.0f : 0.0f);
+}
+
 bool AudioReceiverAudioProcessor::initializeConnection()
 {
     // This is for first-time initialization only
@@ -43,111 +94,196 @@ bool AudioReceiverAudioProcessor::initializeConnection()
 
 bool AudioReceiverAudioProcessor::attemptReconnection()
 {
-    // Only try to reconnect if not already connected
-    if (!isMemoryInitialized || sharedData == nullptr)
+    // Unmap connections the audio thread has finished with.
+    connectionHandoff.collectRetired();
+
+    // Receiving over UDP: remap whenever the receive thread starts a new segment.
+    if (udpReceiver.isRunning() && udpReceiver.getGeneration() != connectedUdpGeneration)
+        return connectToSharedMemory();
+
+    // Only try to reconnect if not already connected. Announced senders wake us through the
+    // stream watcher sooner; this probe finds senders that don't use the directory, and while
+    // nothing is there it costs one failing shm_open.
+    if (!isMemoryInitialized || connectionHandoff.getCurrent() == nullptr)
     {
         DBG("Attempting to reconnect to shared memory...");
         return connectToSharedMemory();
     }
+
+    // Connected: use the same tick to free reader slots left behind by crashed receivers.
+    if (auto* connection = connectionHandoff.getCurrent())
+        connection->getReaders().reapDeadReaders();
+
     return isMemoryInitialized;
 }
 
-//connectToSharedMemory will first try to open the shared memory with read-write permission. If that fails, it falls back to read-only mode. It sets the canWriteToSharedMemory flag appropriately.
-bool AudioReceiverAudioProcessor::connectToSharedMemory()
+void AudioReceiverAudioProcessor::setStreamName(const juce::String& newStreamName)
 {
-    // Clean up any existing connection first
-    cleanupSharedMemory();
-    
-    // First attempt to open the shared memory with read-write access
-    shm_fd = shm_open(SHARED_MEMORY_NAME, O_RDWR, 0666);
-    
-    if (shm_fd == -1)
+    uint16_t port = 0;
+
+    if (UdpReceiver::parseStreamName(newStreamName.trim().toStdString(), port))
     {
-        DBG("Failed to open shared memory with read-write access: " + juce::String(strerror(errno)));
-        
-        // Try again with read-only as fallback
-        shm_fd = shm_open(SHARED_MEMORY_NAME, O_RDONLY, 0666);
-        
-        if (shm_fd == -1)
-        {
-            DBG("Failed to open shared memory: " + juce::String(strerror(errno)));
-            return false;
-        }
-        
-        // If we get here, we opened in read-only mode
-        void* mappedMemory = mmap(0, MAX_BUFFER_SIZE, PROT_READ, MAP_SHARED, shm_fd, 0);
-        
-        if (mappedMemory == MAP_FAILED)
+        if (newStreamName.trim() == streamName)
+            return;
+
+        DBG("Switching to UDP port " + juce::String(port));
+        streamName = newStreamName.trim();
+        connectedStreamOwner = 0;
+        connectedUdpGeneration = 0;
+
+        std::string error;
+
+        if (!udpReceiver.start(port, UdpReceiver::defaultRingFrames, error))
+            DBG("UDP receiver failed: " + juce::String(error));
+
+        // Drops the current mapping; the timer connects once the first packet is in.
+        connectToSharedMemory();
+
+        if (!udpReceiver.isRunning())
+            lastConnectionError = "UDP port " + juce::String(port) + ": " + juce::String(error);
+
+        return;
+    }
+
+    const auto sanitised = juce::String(StreamDirectory::sanitiseName(newStreamName.toStdString()));
+
+    if (sanitised.isEmpty() || sanitised == streamName)
+        return;
+
+    DBG("Switching to stream " + sanitised);
+    streamName = sanitised;
+    udpReceiver.stop();
+
+    // Connect right away if the new stream is announced, or reconnect if we were connected to a
+    // sender that doesn't announce itself; otherwise the watcher or the timer picks it up.
+    connectedStreamOwner = 0;
+
+    if (!handleStreamsChanged() && isMemoryInitialized)
+        connectToSharedMemory();
+}
+
+void AudioReceiverAudioProcessor::setMappingOptions(const SharedConnection::MappingOptions& newOptions)
+{
+    if (newOptions.prefault == mappingOptions.prefault
+        && newOptions.lockPages == mappingOptions.lockPages
+        && newOptions.hugePages == mappingOptions.hugePages)
+        return;
+
+    mappingOptions = newOptions;
+
+    // The options only apply when mapping, so remap now rather than at the next reconnect.
+    if (isMemoryInitialized)
+        connectToSharedMemory();
+}
+
+// A sender published or withdrew a stream. Connect if ours just appeared, and remap if it was
+// re-published by a new sender process (whose segment may not be the one we still have mapped).
+// Returns false if our stream isn't announced at all.
+bool AudioReceiverAudioProcessor::handleStreamsChanged()
+{
+    for (const auto& stream : streamDirectory.listLiveStreams())
+    {
+        if (juce::String(stream.name) != streamName)
+            continue;
+
+        if (!isMemoryInitialized || stream.owner != connectedStreamOwner || !isConnectionActive())
         {
-            DBG("Failed to map shared memory: " + juce::String(strerror(errno)));
-            sharedData = nullptr;
-            close(shm_fd);
-            shm_fd = -1;
-            return false;
+            DBG("Stream " + streamName + " announced, connecting");
+
+            if (connectToSharedMemory())
+                connectedStreamOwner = stream.owner;
         }
-        
-        // Mark that we're in read-only mode
-        canWriteToSharedMemory = false;
-        DBG("Connected to shared memory in READ-ONLY mode");
-        
-        // Cast and check if the data appears valid
-        sharedData = static_cast<SharedAudioData*>(mappedMemory);
-        isMemoryInitialized = true;
+
         return true;
     }
-    else
+
+    return false;
+}
+
+//connectToSharedMemory builds a complete new connection (read-write, falling back to read-only, see SharedConnection::open) and hands it to the audio thread. The previous mapping is retired, not unmapped on the spot.
+bool AudioReceiverAudioProcessor::connectToSharedMemory()
+{
+    juce::String segmentName = streamName;
+
+    if (udpReceiver.isRunning())
     {
-        // We opened in read-write mode successfully
-        void* mappedMemory = mmap(0, MAX_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-        
-        if (mappedMemory == MAP_FAILED)
+        // The generation first: if the segment is replaced in between we simply remap again.
+        connectedUdpGeneration = udpReceiver.getGeneration();
+        segmentName = udpReceiver.getSegmentName();
+
+        if (segmentName.isEmpty())
         {
-            DBG("Failed to map shared memory with read-write permissions: " + juce::String(strerror(errno)));
-            sharedData = nullptr;
-            close(shm_fd);
-            shm_fd = -1;
+            lastConnectionError = "waiting for packets";
+            adoptConnection(nullptr);
             return false;
         }
-        
-        // Mark that we can write to the shared memory
-        canWriteToSharedMemory = true;
-        DBG("Connected to shared memory in READ-WRITE mode");
-        
-        // Cast and check if the data appears valid
-        sharedData = static_cast<SharedAudioData*>(mappedMemory);
+    }
+    else if (uint16_t port = 0; UdpReceiver::parseStreamName(streamName.toStdString(), port))
+    {
+        // The port couldn't be bound; keep that error up rather than probing shm for "udp:...".
+        adoptConnection(nullptr);
+        return false;
+    }
+
+    auto connection = SharedConnection::open(segmentName, mappingOptions, &lastConnectionError);
+    const bool connected = connection != nullptr;
+
+    if (connected)
+        lastConnectionError.clear();
+
+    adoptConnection(std::move(connection));
+    return connected;
+}
+
+void AudioReceiverAudioProcessor::adoptConnection(std::unique_ptr<SharedConnection> connection)
+{
+    connectionHandoff.publish(std::move(connection));
+
+    // Keep the SharedMemoryManager members as the message thread's view of the current mapping.
+    cleanupSharedMemory();
+
+    if (auto* current = connectionHandoff.getCurrent())
+    {
+        sharedData = current->getData();
+        shm_fd = current->getFileDescriptor();
+        canWriteToSharedMemory = current->isWritable();
         isMemoryInitialized = true;
-        return true;
+    }
+    else
+    {
+        canWriteToSharedMemory = false;
     }
 }
 
 
 AudioReceiverAudioProcessor::~AudioReceiverAudioProcessor()
 {
-    // Stop the timer before destruction
+    // Stop the timer and the watcher before destruction
     if (reconnectionTimer != nullptr)
         reconnectionTimer->stopTimer();
+
+    streamWatcher.stop();
+    telemetryCollector.stop();
     
     reconnectionTimer = nullptr;
     
-    cleanupSharedMemory();
+    udpReceiver.stop();
+    disconnectFromSharedMemory();
+}
+
+void AudioReceiverAudioProcessor::disconnectFromSharedMemory()
+{
+    adoptConnection(nullptr);
 }
 
 //==============================================================================
 
 void SharedMemoryManager::cleanupSharedMemory()
 {
-    if (sharedData != nullptr)
-    {
-        munmap(sharedData, MAX_BUFFER_SIZE);
-        sharedData = nullptr;
-    }
-
-    if (shm_fd != -1)
-    {
-        close(shm_fd);
-        shm_fd = -1;
-    }
-    
+    // The receiver's mappings are owned (and unmapped) by SharedConnection, which outlives this
+    // view until the audio thread has let go of it. Here we only forget the current one.
+    sharedData = nullptr;
+    shm_fd = -1;
     isMemoryInitialized = false;
 }
 
@@ -224,6 +360,45 @@ void AudioReceiverAudioProcessor::changeProgramName (int index, const juce::Stri
 void AudioReceiverAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     DBG("Receiver plugin ready to play");
+
+    // The jitter buffer picks the slack to keep in the ring; a quarter of the ring at most, so the
+    // sender always has room to write.
+    currentSampleRate = sampleRate;
+    telemetryCollector.setSampleRate(sampleRate);
+    hostTimeline.prepare(sampleRate);
+    // (processBlock moves the ceiling when a connection with a different ring size arrives).
+    auto* connection = connectionHandoff.getCurrent();
+    const uint64_t ringFrames = connection != nullptr ? connection->getRingMask() + 1 : (uint64_t) SharedAudioData::BUFFER_MASK + 1;
+    jitterBuffer.prepare(sampleRate, samplesPerBlock, (double) ringFrames / 4.0);
+    const double targetFill = jitterBuffer.getTargetDepth();
+
+    driftController.prepare(sampleRate, targetFill);
+    resampler.prepare(juce::jlimit(1, RoutingMatrix::maxOutputs, getTotalNumOutputChannels()), samplesPerBlock,
+                      1.0 + DriftController::maxCorrection);
+
+    // Sized for the widest conversion; the filter is designed once the sender's rate is known.
+    rateConverter.prepare(resampler.getNumChannels(), samplesPerBlock,
+                          PolyphaseResampler::maxConversion * (1.0 + DriftController::maxCorrection));
+    conversionRatio = 1.0;
+
+    // Only enabled buses are in the host's buffer; the plan maps their channels back to their rows.
+    const uint32_t previousLayoutId = outputLayout.id;
+    outputLayout = describeOutputLayout();
+    outputLayout.id = previousLayoutId + 1;
+
+    // Non-contiguous routes are de-interleaved here first; bigger reads go through in chunks.
+    routingScratch.setSize(RoutingMatrix::maxSources, samplesPerBlock * 2 + 16);
+    readCursorPrimed = false;
+
+    // Gain changes are ramped over 20 ms; a new session starts at the parameter's value.
+    outputGain.reset(sampleRate, 0.02);
+    outputGain.setCurrentAndTargetValue(gainToLinear(gainParameter->load()));
+
+    // Remembers the tail of the output (every channel the buffer may have) for hiding dropouts.
+    concealer.prepare(sampleRate, juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels()));
+
+    receiverMetrics.targetFill.store(targetFill, std::memory_order_relaxed);
+    updateReportedLatency();
     
     //Cubase might instantiate the plugin before the audio thread is active. //Deferring shared memory setup until prepareToPlay():
     if (!isMemoryInitialized)
@@ -232,7 +407,7 @@ void AudioReceiverAudioProcessor::prepareToPlay (double sampleRate, int samplesP
 
 void AudioReceiverAudioProcessor::releaseResources()
 {
-    cleanupSharedMemory();
+    disconnectFromSharedMemory();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -242,83 +417,641 @@ bool AudioReceiverAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
     juce::ignoreUnused(layouts);
     return true;
 #else
-    // Always require the main output bus to have exactly 8 channels.
-    if (layouts.getMainOutputChannelSet().size() != 10)
-        return false;
+    // Any main output width the routing matrix has rows for. The other buses can be switched off
+    // but keep their declared layouts, since each one plays a fixed range of rows.
+    const int mainOutputs = layouts.getMainOutputChannelSet().size();
+    int rows = mainOutputs;
 
-    return true;
+    for (int busIndex = 1; busIndex < layouts.outputBuses.size(); ++busIndex)
+    {
+        const auto& channelSet = layouts.getChannelSet(false, busIndex);
+        const auto* bus = getBus(false, busIndex);
+        const int declared = bus != nullptr ? bus->getDefaultLayout().size() : channelSet.size();
+
+        if (!channelSet.isDisabled() && channelSet.size() != declared)
+            return false;
+
+        rows += declared;
+    }
+
+    return mainOutputs > 0 && rows <= RoutingMatrix::maxOutputs;
 #endif
 }
 #endif
 
+RoutingMatrix::OutputLayout AudioReceiverAudioProcessor::describeOutputLayout() const
+{
+    RoutingMatrix::OutputLayout layout;
+    layout.numChannels = 0;
+    int row = 0;
+
+    for (int busIndex = 0; busIndex < getBusCount(false); ++busIndex)
+    {
+        const auto* bus = getBus(false, busIndex);
+
+        // A disabled bus holds on to its declared width's rows.
+        const int width = bus->isEnabled() ? bus->getNumberOfChannels() : bus->getDefaultLayout().size();
+
+        for (int channel = 0; bus->isEnabled() && channel < width && row + channel < RoutingMatrix::maxOutputs; ++channel)
+            layout.rows[layout.numChannels++] = (uint8_t) (row + channel);
+
+        row += width;
+    }
+
+    layout.numRows = juce::jmin(row, RoutingMatrix::maxOutputs);
+    return layout;
+}
+
 
 //The key changes here are the addition of the if (canWriteToSharedMemory && sharedData != nullptr) checks before any attempt to write to the shared memory.
 void AudioReceiverAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
 
-    // Skip processing if shared memory isn't initialized or active.
-    if (!isMemoryInitialized || sharedData == nullptr || !sharedData->isActive.load())
+    // Timed and recorded for the telemetry collector however we leave this function.
+    TelemetryRing::ScopedBlock telemetry(telemetryRing, buffer.getNumSamples());
+
+    // Picked up once per block, then ramped towards sample by sample inside the copy.
+    outputGain.setTargetValue(gainToLinear(gainParameter->load(std::memory_order_relaxed)));
+
+    // Pin the current connection for this block. The message thread won't unmap it until we
+    // release it at the end of the block, even if it publishes a new one meanwhile.
+    ConnectionHandoff<SharedConnection>::ReadScope connection(connectionHandoff);
+
+    // The sender's sample encoding and the frame it took effect at, read before writeIndex so the
+    // frame can't be ahead of it for a live sender (see SampleFormat.h).
+    auto ringFormat = connection ? connection->getRingFormat() : ReaderTableLayout::RingFormat();
+
+    // Convert if the sender runs at another rate than ours (see updateConversion).
+    const bool rateSupported = connection && updateConversion(connection->getSampleRate());
+
+    // Skip processing if shared memory isn't initialized or active, the sender writes an encoding
+    // we never offered or that doesn't fit its own sample area, or its rate is beyond conversion.
+    if (!connection || !connection->isSenderActive() || ringFormat.encoding >= SampleFormat::numEncodings
+        || (size_t) SampleFormat::bytesPerSample(ringFormat.encoding) > connection->getMaxBytesPerSample()
+        || !rateSupported)
     {
-        buffer.clear();
+        // A sender that stops mid-stream fades out like any other dropout.
+        telemetry.record.flags |= TelemetryRing::disconnected;
+
+        if (concealer.conceal(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), 0, buffer.getNumSamples()))
+        {
+            receiverMetrics.concealments.fetch_add(1, std::memory_order_relaxed);
+            telemetry.record.flags |= TelemetryRing::concealed;
+        }
+
+        // The concealer works from what was played, gain included.
+        receiverMetrics.concealedBlocks.fetch_add(1, std::memory_order_relaxed);
+        outputGain.skip(buffer.getNumSamples());
+        levelMeter.publish(nullptr, 0, buffer.getNumSamples());
+        captureTap.push(buffer.getArrayOfReadPointers(), buffer.getNumChannels(), buffer.getNumSamples());
         return;
     }
 
-    int numSamples = buffer.getNumSamples();
-    // We're using a single merged output bus of 8 channels (as per your isBusesLayoutSupported)
-    int outputChannels = buffer.getNumChannels(); // should be 8
+    // Get current shared memory indices. The sub-blocks work from this copy of writeIndex unless
+    // it runs short (see processSubBlock).
+    const uint64_t writeIndex = connection->loadWriteIndex();
+    observedWriteIndex = writeIndex;
+    const uint64_t ringCapacity = connection->getRingMask() + 1;
+
+    // A format record ahead of the sender belongs to an earlier session (e.g. an older sender that
+    // doesn't know about encodings took over the segment), so it no longer applies.
+    if (ringFormat.firstFrame > writeIndex)
+        ringFormat = ReaderTableLayout::RingFormat();
+
+    if (ringFormat.encoding != ringEncoding)
+    {
+        ringEncoding = ringFormat.encoding;
+        receiverMetrics.ringEncoding.store((uint32_t) ringEncoding, std::memory_order_relaxed);
+    }
+
+    // A new mapping (reconnect or stream change): our cursor belongs to the old one, and its ring
+    // may be a different size.
+    const bool isNewConnection = connection->getId() != audioThreadConnectionId;
 
-    // Shared memory now contains 10 channels.
-    const int totalSharedChannels = 10;
-    const int dummyChannels = 2;
+    if (isNewConnection)
+    {
+        audioThreadConnectionId = connection->getId();
+        legacyReadIndex = 0;
+        blocksSinceLegacyMirror = 0;
+        jitterBuffer.setMaxDepth((double) ringCapacity / 4.0);
+        senderTimeline.prepare(connection->getSampleRate());
+        lastAnchorSequence = 0;
+    }
 
+    updateTimelines(*connection.get(), buffer.getNumSamples());
 
-    // Get current shared memory indices.
-    uint64_t writeIndex = sharedData->writeIndex.load(std::memory_order_acquire);
-    uint64_t readIndex  = lastReadIndex;
-    uint64_t available  = writeIndex - readIndex;
+    // Follow the jitter buffer (user setting or automatic tuning). The drift controller eases the
+    // ring towards a smaller target; a larger one takes effect at the next rebuffer.
+    const double targetFill = jitterBuffer.getTargetDepth();
 
-    // Check if we have enough frames available.
-    if (available < (uint64_t) numSamples)
+    if (targetFill != driftController.getTargetFill())
     {
-        buffer.clear();
-        sharedData->metrics.bufferUnderruns.fetch_add(1, std::memory_order_relaxed);
-        if (available < (uint64_t) numSamples / 2 && writeIndex > (uint64_t) numSamples * 2)
+        driftController.setTargetFill(targetFill);
+        receiverMetrics.targetFill.store(targetFill, std::memory_order_relaxed);
+    }
+
+    telemetry.record.targetFill = (uint32_t) targetFill;
+
+    // Hosts may hand us any block size: more than prepareToPlay announced, or several of the
+    // sender's periods at once (offline renders especially). Work through the block in pieces the
+    // resamplers were prepared for, each taking a fresh look at writeIndex, so drift correction and
+    // rate conversion stay on, every frame that has arrived is delivered and only the frames that
+    // really are missing get concealed.
+    const int numSamples = buffer.getNumSamples();
+    const int subBlockSize = juce::jmax(1, resamplerMaxOutputFrames());
+
+    for (int offset = 0; offset < numSamples; offset += subBlockSize)
+    {
+        // Refers to the host's channels from offset on (no allocation for up to 32 channels).
+        juce::AudioBuffer<float> subBlock(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), offset,
+                                          juce::jmin(subBlockSize, numSamples - offset));
+
+        processSubBlock(*connection.get(), subBlock, offset, ringFormat.firstFrame, isNewConnection && offset == 0, telemetry.record);
+    }
+
+    // Exactly what we hand the host, concealment and gain included.
+    captureTap.push(buffer.getArrayOfReadPointers(), buffer.getNumChannels(), numSamples);
+}
+
+// One piece of the host block: read what the ring holds for it, conceal any shortfall, steer the
+// drift controller and publish the cursor, meters and metrics. forceResync moves the cursor to
+// the target fill first (new connection). offset is where the piece starts in the host block.
+void AudioReceiverAudioProcessor::processSubBlock(SharedConnection& connection, juce::AudioBuffer<float>& buffer, int offset,
+                                                  uint64_t earliestFrame, bool forceResync, TelemetryRing::Record& telemetry)
+{
+    const SharedConnection& shared = connection;
+
+    const int numSamples = buffer.getNumSamples();
+    // All output buses as one buffer; the routing matrix decides what lands on each channel
+    const int outputChannels = buffer.getNumChannels();
+
+    const uint64_t ringCapacity = shared.getRingMask() + 1;
+
+    // The copy of writeIndex processBlock loaded. It lives on the sender's cache line, so every
+    // load after the sender wrote to it is a cross-core miss; the copy is good for as long as it
+    // covers what we read, and only a sub-block it doesn't cover looks again (below).
+    const uint64_t writeIndex = observedWriteIndex;
+
+    // Where the sender's timeline is for this piece (see Alignment). The target fill is counted
+    // back from there, but never from past what has actually been written.
+    const auto timeline = locateTimeline(offset, writeIndex, ringCapacity);
+    const bool aligned = !std::isnan(timeline.alignedFrame);
+    const uint64_t referenceFrame = aligned ? juce::jmin(writeIndex, (uint64_t) juce::jmax(0.0, timeline.alignedFrame)) : writeIndex;
+    const double senderRate = currentSampleRate * conversionRatio;
+    const double targetFill = driftController.getTargetFill();
+
+    // The sender restarted (its index went backwards), we are so far behind that the frames we
+    // would read are about to be overwritten, the sender switched encodings past our cursor, or
+    // a playing cursor has come adrift of the timeline it is aligned with: jump straight to the
+    // target fill. This and the alignment of a cursor that isn't playing yet (below) are the only
+    // places the read cursor moves other than by reading.
+    if (forceResync || writeIndex < lastReadIndex || writeIndex - lastReadIndex > ringCapacity / 2
+        || lastReadIndex < earliestFrame
+        || (aligned && readCursorPrimed
+            && std::abs(timeline.alignedFrame - (double) lastReadIndex - targetFill)
+                   > realignAfterMs * senderRate / 1000.0 + (double) numSamples * conversionRatio))
+    {
+        resyncReadIndex(connection, referenceFrame, earliestFrame);
+        telemetry.flags |= TelemetryRing::resync;
+    }
+
+    // Offline the host waits for us rather than the other way round, so there is no clock to
+    // drift against: read the sender's frames one for one and wait for the ones it hasn't written.
+    const bool offline = isNonRealtime();
+
+    // Small drift corrections go through the resampler, on top of the rate conversion if the
+    // sender runs at another rate.
+    const bool compensateDrift = !offline && driftCompensationParameter->load(std::memory_order_relaxed) >= 0.5f;
+    const bool useResampler = compensateDrift || conversionRatio != 1.0;
+    const double ratio = useResampler ? conversionRatio * (compensateDrift ? driftController.getRatio() : 1.0) : 1.0;
+    const int framesNeeded = useResampler ? resamplerInputFramesNeeded(numSamples, ratio) : numSamples;
+
+    // Aligned, a cursor that isn't playing yet moves up to where the timeline wants this piece to
+    // start, so playing resumes exactly the target fill behind it. Never back: that would replay.
+    if (aligned && !readCursorPrimed && referenceFrame > (uint64_t) targetFill + (uint64_t) framesNeeded)
+        lastReadIndex = juce::jmax(lastReadIndex, referenceFrame - (uint64_t) targetFill - (uint64_t) framesNeeded);
+
+    uint64_t available = writeIndex - lastReadIndex;
+
+    // Our copy doesn't cover this sub-block: see whether more has arrived. A restart seen only now
+    // is caught by the resync check next time round.
+    if (available < (uint64_t) framesNeeded)
+    {
+        observedWriteIndex = shared.loadWriteIndex();
+        available = observedWriteIndex > lastReadIndex ? juce::jmin(observedWriteIndex - lastReadIndex, ringCapacity / 2) : 0;
+    }
+
+    telemetry.gap = (uint32_t) juce::jmin(available, (uint64_t) UINT32_MAX);
+
+    if (offlineSenderStalled && observedWriteIndex != offlineStallWriteIndex)
+        offlineSenderStalled = false;
+
+    if (offline && available < (uint64_t) framesNeeded && !offlineSenderStalled)
+    {
+        const uint64_t reached = shared.waitForWriteIndex(lastReadIndex + (uint64_t) framesNeeded, offlineWaitTimeoutMs);
+        observedWriteIndex = reached;
+        telemetry.flags |= TelemetryRing::waited;
+
+        // A sender that restarted meanwhile is caught by the resync check next sub-block.
+        available = reached > lastReadIndex ? juce::jmin(reached - lastReadIndex, ringCapacity / 2) : 0;
+        offlineSenderStalled = available < (uint64_t) framesNeeded;
+        offlineStallWriteIndex = reached;
+    }
+
+    // After a start or an underrun, let the ring fill back up to the target before playing again
+    // rather than limping along a few samples ahead of the sender. Offline there is nothing to
+    // absorb, so the frames for this block are enough.
+    if (!readCursorPrimed)
+        readCursorPrimed = available >= (offline ? 0 : (uint64_t) driftController.getTargetFill()) + (uint64_t) framesNeeded;
+
+    // Not enough frames: play what there is of the block, then conceal the rest (see
+    // UnderrunConcealer) rather than cutting to silence.
+    if (!readCursorPrimed || available < (uint64_t) framesNeeded)
+    {
+        int playedFrames = 0, inputFrames = 0, routedChannels = 0;
+        RingDeinterleave::ChannelStats channelStats[ChannelLevelMeter::maxChannels];
+
+        if (readCursorPrimed && available > 0)
+        {
+            // Through the resampler when it is in use, so the partial audio joins up with the last block.
+            playedFrames = useResampler ? juce::jmin(numSamples - 1, resamplerOutputFramesFor((int) available, ratio))
+                                        : (int) available;
+            inputFrames = useResampler ? resamplerInputFramesNeeded(playedFrames, ratio) : playedFrames;
+
+            if (playedFrames > 0)
+            {
+                routedChannels = readIntoBuffer(shared, buffer, inputFrames, playedFrames, useResampler, ratio, channelStats,
+                                                nextGainRamp(playedFrames, inputFrames));
+                lastReadIndex += (uint64_t) inputFrames;
+            }
+        }
+
+        outputGain.skip(numSamples - playedFrames);
+
+        if (concealer.conceal(buffer.getArrayOfWritePointers(), outputChannels, playedFrames, numSamples - playedFrames))
         {
-            lastReadIndex = writeIndex - numSamples * 2;
-            sharedData->readIndex.store(lastReadIndex, std::memory_order_release);
+            receiverMetrics.concealments.fetch_add(1, std::memory_order_relaxed);
+            telemetry.flags |= TelemetryRing::concealed;
         }
+
+        receiverMetrics.concealedBlocks.fetch_add(1, std::memory_order_relaxed);
+        levelMeter.publish(playedFrames > 0 ? channelStats : nullptr, routedChannels, playedFrames > 0 ? inputFrames : numSamples);
+        publishReadIndex(connection); // Keeps our reader lease alive even if the cursor didn't move
+        telemetry.flags |= readCursorPrimed ? TelemetryRing::underrun : TelemetryRing::rebuffering;
+
+        if (readCursorPrimed)
+        {
+            if (connection.isWritable())
+                connection.addUnderrun();
+
+            receiverMetrics.bufferUnderruns.fetch_add(1, std::memory_order_relaxed);
+
+            // Keep the cursor where it is (jumping back would replay old audio) and rebuffer,
+            // deeper if the jitter buffer is tuning itself.
+            jitterBuffer.noteUnderrun();
+            readCursorPrimed = false;
+            resetResamplers();
+            driftController.reset(true);
+        }
+        return;
+    }
+
+    RingDeinterleave::ChannelStats channelStats[ChannelLevelMeter::maxChannels];
+    const int routedChannels = readIntoBuffer(shared, buffer, framesNeeded, numSamples, useResampler, ratio, channelStats,
+                                              nextGainRamp(numSamples, framesNeeded));
+
+    // First block after a concealment fades back in.
+    if (concealer.played(buffer.getArrayOfWritePointers(), outputChannels, numSamples))
+        receiverMetrics.concealedBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    // How far behind the sender's clock and our playhead the frames just read are.
+    receiverMetrics.alignedTo.store((uint32_t) timeline.alignedTo, std::memory_order_relaxed);
+    receiverMetrics.timelineOffsetMs.store(std::isnan(timeline.clockFrame) ? 0.0
+                                               : JitterBuffer::toMilliseconds(timeline.clockFrame - (double) lastReadIndex, senderRate),
+                                           std::memory_order_relaxed);
+    receiverMetrics.transportOffsetMs.store(std::isnan(timeline.transportFrame) ? 0.0
+                                                : JitterBuffer::toMilliseconds(timeline.transportFrame - (double) lastReadIndex, senderRate),
+                                            std::memory_order_relaxed);
+
+    // Update local read position.
+    lastReadIndex += (uint64_t) framesNeeded;
+    publishReadIndex(connection);
+
+    // Steer the next block's ratio from the fill we left behind: in the ring, or behind the
+    // timeline we are aligned with, which doesn't jump with the sender's block cadence.
+    const double ringFillAfterRead = (double) (available - (uint64_t) framesNeeded);
+    const double fillAfterRead = aligned ? timeline.alignedFrame - (double) lastReadIndex : ringFillAfterRead;
+    telemetry.flags |= TelemetryRing::played;
+    telemetry.fill = (uint32_t) ringFillAfterRead;
+    jitterBuffer.notePlayed(numSamples);
+
+    if (useResampler && compensateDrift)
+    {
+        driftController.update(fillAfterRead, numSamples);
+
+        receiverMetrics.resampleRatio.store(driftController.getRatio(), std::memory_order_relaxed);
+        receiverMetrics.driftPpm.store(driftController.getDriftPpm(), std::memory_order_relaxed);
+        receiverMetrics.fillLevel.store(driftController.getSmoothedFill(), std::memory_order_relaxed);
+    }
+
+    // What the listener is actually behind the sender by, for the sender's metrics and our own.
+    const double latencyMs = JitterBuffer::toMilliseconds(useResampler && compensateDrift ? driftController.getSmoothedFill() : fillAfterRead,
+                                                          currentSampleRate * conversionRatio);
+    receiverMetrics.latencyMs.store(latencyMs, std::memory_order_relaxed);
+
+    if (connection.isWritable())
+        connection.storeLatency(latencyMs);
+
+    // Publish post-gain levels for metering (measured by the copy, not by re-reading the buffer).
+    levelMeter.publish(channelStats, routedChannels, framesNeeded);
+}
+
+// Advances the gain smoother by numSamples output samples and returns the ramp across the
+// numFrames ring frames read for them, which differ when resampling. The last frame stops one
+// step short of the end value, where the next block's ramp starts.
+RingDeinterleave::GainRamp AudioReceiverAudioProcessor::nextGainRamp(int numSamples, int numFrames) noexcept
+{
+    const float start = outputGain.getCurrentValue();
+
+    if (!outputGain.isSmoothing())
+        return { start, 0.0f };
+
+    outputGain.skip(numSamples);
+    return { start, numFrames > 0 ? (outputGain.getCurrentValue() - start) / (float) numFrames : 0.0f };
+}
+
+// Route shared channels to the outputs (see RoutingMatrix), straight into the planar output or
+// into the resampler's input when drift compensation is on. Plain offset maps, the default
+// included, take a compile-time specialised kernel; anything else is de-interleaved once and
+// then copied or summed. Outputs past the last routed one are silent. The buffer only holds the
+// enabled buses, so a disabled bus costs no reading, gain or metering at all.
+// The gain ramp and the peak and sum of squares per output for the meters are handled by the same
+// pass. Compact encodings are decoded on the way through. Returns the number of routed channels.
+int AudioReceiverAudioProcessor::readIntoBuffer(const SharedConnection& shared, juce::AudioBuffer<float>& buffer,
+                                                int inputFrames, int outputFrames, bool useResampler, double ratio,
+                                                RingDeinterleave::ChannelStats* stats, const RingDeinterleave::GainRamp& gain)
+{
+    const int outputChannels = buffer.getNumChannels();
+    routingMatrix.updatePlan(routingPlan, shared.getNumChannels(), outputLayout);
+
+    // While converting rates the polyphase converter stands in for the drift resampler.
+    const bool convert = conversionRatio != 1.0;
+    const int resamplerChannels = convert ? rateConverter.getNumChannels() : resampler.getNumChannels();
+    const int routedChannels = juce::jmin(outputChannels, routingPlan.numOutputs, useResampler ? resamplerChannels : outputChannels);
+    float* const* routeDest = !useResampler ? buffer.getArrayOfWritePointers()
+                                            : convert ? rateConverter.getInputPointers() : resampler.getInputPointers();
+
+    if (routingPlan.contiguous)
+        readSharedChannels(shared, routingPlan.firstSource, lastReadIndex, inputFrames, routeDest, routedChannels, stats, gain);
+    else
+        readRouted(shared, routeDest, routedChannels, inputFrames, stats, gain);
+
+    if (useResampler && convert)
+        rateConverter.process(inputFrames, buffer.getArrayOfWritePointers(), routedChannels, outputFrames, ratio);
+    else if (useResampler)
+        resampler.process(inputFrames, buffer.getArrayOfWritePointers(), routedChannels, outputFrames, ratio);
+
+    for (int ch = routedChannels; ch < outputChannels; ++ch)
+        buffer.clear(ch, 0, outputFrames);
+
+    return routedChannels;
+}
+
+void AudioReceiverAudioProcessor::readSharedChannels(const SharedConnection& shared, int firstSource, uint64_t readIndex,
+                                                     int numFrames, float* const* dest, int numDest,
+                                                     RingDeinterleave::ChannelStats* stats, const RingDeinterleave::GainRamp& gain)
+{
+    if (ringEncoding == SampleFormat::float32)
+        RingDeinterleave::readContiguous(reinterpret_cast<const float*>(shared.getSamples()), shared.getRingMask(),
+                                         shared.getNumChannels(), firstSource, readIndex, numFrames, dest, numDest, stats, gain);
+    else
+        RingDeinterleave::readFromRingEncoded(shared.getSamples(), ringEncoding, shared.getRingMask(), shared.getNumChannels(),
+                                              firstSource, readIndex, numFrames, dest, numDest, stats, gain);
+}
+
+void AudioReceiverAudioProcessor::readRouted(const SharedConnection& shared, float* const* dest, int numOutputs, int numFrames,
+                                             RingDeinterleave::ChannelStats* stats, const RingDeinterleave::GainRamp& gain)
+{
+    const int numSources = routingPlan.highestSource - routingPlan.lowestSource + 1;
+    const int chunk = routingScratch.getNumSamples();
+
+    if (numSources <= 0 || chunk <= 0)
         return;
+
+    for (int offset = 0; offset < numFrames; offset += chunk)
+    {
+        const int frames = juce::jmin(chunk, numFrames - offset);
+
+        readSharedChannels(shared, routingPlan.lowestSource, lastReadIndex + (uint64_t) offset, frames,
+                           routingScratch.getArrayOfWritePointers(), numSources, nullptr);
+        RoutingMatrix::render(routingPlan, routingScratch.getArrayOfReadPointers(), dest, numOutputs, offset, frames, stats, gain);
     }
+}
+
+// Sender rate over host rate for the coming block. A change (new connection, or the host moved to
+// another rate) redesigns the converter's filter, which takes a fraction of a millisecond and does
+// not allocate, and starts it over. Returns false if the ratio is beyond what the converter covers.
+bool AudioReceiverAudioProcessor::updateConversion(double senderSampleRate)
+{
+    // Senders that don't state their rate (legacy layout) are taken to run at ours.
+    const double wanted = senderSampleRate > 0.0 && currentSampleRate > 0.0
+                              && std::abs(senderSampleRate - currentSampleRate) > 1.0e-6 * currentSampleRate
+                          ? senderSampleRate / currentSampleRate : 1.0;
 
-    // For each sample, copy shared memory channels (dummyChannels to dummyChannels+outputChannels-1)
-    for (int sample = 0; sample < numSamples; ++sample)
+    if (wanted > PolyphaseResampler::maxConversion || wanted < 1.0 / PolyphaseResampler::maxConversion)
+        return false;
+
+    if (wanted != conversionRatio)
     {
-        uint64_t frameIndex = (readIndex + sample) & SharedAudioData::BUFFER_MASK;
-        for (int ch = 0; ch < outputChannels; ++ch)
+        conversionRatio = wanted;
+
+        if (conversionRatio != 1.0)
+            rateConverter.design(conversionRatio);
+
+        resetResamplers();
+        driftController.reset();
+        jitterBuffer.setFrameRate(currentSampleRate * conversionRatio);
+        readCursorPrimed = false;
+
+        receiverMetrics.senderSampleRate.store(senderSampleRate, std::memory_order_relaxed);
+        receiverMetrics.conversionRatio.store(conversionRatio, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+int AudioReceiverAudioProcessor::resamplerInputFramesNeeded(int numOutput, double ratio) const noexcept
+{
+    return conversionRatio != 1.0 ? rateConverter.getInputFramesNeeded(numOutput, ratio)
+                                  : resampler.getInputFramesNeeded(numOutput, ratio);
+}
+
+int AudioReceiverAudioProcessor::resamplerOutputFramesFor(int numInput, double ratio) const noexcept
+{
+    return conversionRatio != 1.0 ? rateConverter.getOutputFramesFor(numInput, ratio)
+                                  : resampler.getOutputFramesFor(numInput, ratio);
+}
+
+int AudioReceiverAudioProcessor::resamplerMaxOutputFrames() const noexcept
+{
+    return conversionRatio != 1.0 ? rateConverter.getMaxOutputFrames() : resampler.getMaxOutputFrames();
+}
+
+void AudioReceiverAudioProcessor::resetResamplers() noexcept
+{
+    resampler.reset();
+    rateConverter.reset();
+}
+
+void AudioReceiverAudioProcessor::updateReportedLatency()
+{
+    // Hosts re-run delay compensation on every change, so only call when the depth really moved.
+    // The buffer is counted in sender frames; a rate converter adds its filter delay on top.
+    const double ratio = receiverMetrics.conversionRatio.load(std::memory_order_relaxed);
+    const double converterDelay = ratio != 1.0 ? (double) PolyphaseResampler::getLatencyFrames() : 0.0;
+    const int latencySamples = juce::roundToInt((receiverMetrics.targetFill.load(std::memory_order_relaxed) + converterDelay) / ratio);
+
+    if (latencySamples != getLatencySamples())
+        setLatencySamples(latencySamples);
+}
+
+// Once per host block: takes the block's time off our own timeline, picks up the sender's latest
+// anchor and reads the playhead.
+void AudioReceiverAudioProcessor::updateTimelines(const SharedConnection& connection, int numSamples)
+{
+    hostTimeline.update(hostSamplePosition, SegmentLayout::monotonicNanos());
+    blockClockNs = hostTimeline.clockAt(hostSamplePosition);
+    hostSamplePosition += (uint64_t) numSamples;
+
+    SegmentLayout::Anchor anchor;
+    const uint64_t sequence = connection.readAnchor(anchor);
+
+    if (sequence != 0 && sequence != lastAnchorSequence)
+    {
+        lastAnchorSequence = sequence;
+        senderTimeline.update(anchor.frame, anchor.clockNs);
+        senderTransport = anchor;
+    }
+
+    blockPpq = std::numeric_limits<double>::quiet_NaN();
+    blockBpm = 0.0;
+
+    if (auto* playHead = getPlayHead())
+    {
+        if (const auto position = playHead->getPosition(); position && position->getIsPlaying())
         {
-            int sharedChannel = dummyChannels + ch; // Map receiver output ch directly to shared channel ch.
-            int sharedBufferIndex = (frameIndex * totalSharedChannels) + sharedChannel;
-            float sampleValue = sharedData->audioData[sharedBufferIndex];
-            buffer.setSample(ch, sample, sampleValue);
+            blockPpq = position->getPpqPosition().orFallback(std::numeric_limits<double>::quiet_NaN());
+            blockBpm = position->getBpm().orFallback(0.0);
         }
+    }
+}
 
+// The sender frames due at the start of the piece `offset` samples into this block, by the clock
+// and by the transport, and which of them to line up with. A frame that isn't within a quarter of
+// the ring of writeIndex is from an anchor that no longer fits what the sender writes (it stopped
+// anchoring, or restarted and hasn't anchored yet), or a transport position the ring can't serve.
+AudioReceiverAudioProcessor::TimelinePosition AudioReceiverAudioProcessor::locateTimeline(int offset, uint64_t writeIndex,
+                                                                                          uint64_t ringCapacity) const noexcept
+{
+    TimelinePosition position;
+
+    if (!senderTimeline.isValid() || isNonRealtime())
+        return position;
+
+    const double seconds = (double) offset / currentSampleRate;
+    const double senderRate = currentSampleRate * conversionRatio;
+    const double window = (double) ringCapacity / 4.0;
+    auto usable = [&](double frame) { return std::abs(frame - (double) writeIndex) <= window; };
+
+    const double clockFrame = senderTimeline.frameAt(blockClockNs + (int64_t) std::llround(seconds * 1.0e9));
+
+    if (usable(clockFrame))
+        position.clockFrame = clockFrame;
+
+    // Both tempos are taken to be ours.
+    if (!std::isnan(blockPpq) && blockBpm > 0.0 && senderTransport.hasPpq())
+    {
+        const double transportFrame = (double) senderTransport.frame
+                                      + ((blockPpq - senderTransport.ppq) * 60.0 / blockBpm + seconds) * senderRate;
+
+        if (usable(transportFrame))
+            position.transportFrame = transportFrame;
     }
 
-    // Update local read position.
-    lastReadIndex = readIndex + numSamples;
-    sharedData->readIndex.store(lastReadIndex, std::memory_order_release);
+    const auto mode = alignment.load(std::memory_order_relaxed);
+
+    if (mode == Alignment::hostTransport && !std::isnan(position.transportFrame))
+    {
+        position.alignedFrame = position.transportFrame;
+        position.alignedTo = Alignment::hostTransport;
+    }
+    else if (mode != Alignment::ringFill && !std::isnan(position.clockFrame))
+    {
+        position.alignedFrame = position.clockFrame;
+        position.alignedTo = Alignment::senderClock;
+    }
+
+    return position;
+}
+
+// referenceFrame is writeIndex, or the aligned timeline's frame if that is further back.
+void AudioReceiverAudioProcessor::resyncReadIndex(SharedConnection& connection, uint64_t referenceFrame, uint64_t earliestFrame)
+{
+    const uint64_t target = (uint64_t) driftController.getTargetFill();
 
-    // Apply gain to the entire output buffer.
-    buffer.applyGain(gain);
+    // Never behind earliestFrame: frames before it are in a different encoding.
+    lastReadIndex = juce::jmax(referenceFrame > target ? referenceFrame - target : 0, earliestFrame);
+    publishReadIndex(connection);
 
-    // Update RMS level for metering.
+    readCursorPrimed = false;
+    resetResamplers();
+    driftController.reset(true);
+
+    receiverMetrics.resyncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioReceiverAudioProcessor::publishReadIndex(SharedConnection& connection)
+{
+    // Our own slot in the reader table: one cache line only we write.
+    auto& readers = connection.getReaders();
+    readers.publishCursor(lastReadIndex);
+
+    // A read-only mapping can't take the store (it would fault), so the sender just doesn't see
+    // our cursor in that case.
+    if (!connection.isWritable())
+        return;
+
+    if (!readers.hasSlot())
     {
-        const juce::ScopedLock sl(levelLock);
-        currentLevel = AudioLevelUtils::calculateRMSLevel(buffer);
+        connection.storeReadIndex(lastReadIndex);
+        return;
+    }
+
+    // Senders that only know the single readIndex still get a consistent view: every receiver
+    // mirrors the slowest live reader there rather than its own cursor. Cursors only move forward,
+    // so a minimum taken a few blocks ago is conservative and we don't need to rescan every block.
+    if (++blocksSinceLegacyMirror >= legacyMirrorInterval)
+    {
+        blocksSinceLegacyMirror = 0;
+
+        uint64_t minimum = lastReadIndex;
+        readers.getMinimumCursor(minimum);
+
+        if (minimum != legacyReadIndex)
+        {
+            legacyReadIndex = minimum;
+            connection.storeReadIndex(legacyReadIndex);
+        }
     }
 }
 
+// At the host's rate and with one track per output channel, whatever the routing.
+bool AudioReceiverAudioProcessor::startCapture(const juce::File& file, juce::String& error)
+{
+    return captureTap.start(file, currentSampleRate, getTotalNumOutputChannels(), error);
+}
+
 
 
 
@@ -334,17 +1067,91 @@ juce::AudioProcessorEditor* AudioReceiverAudioProcessor::createEditor()
 }
 
 //==============================================================================
+namespace StateIds
+{
+    static const juce::Identifier root { "AudioReceiverState" };
+    static const juce::Identifier streamName { "streamName" };
+    static const juce::Identifier bufferMode { "bufferMode" };     // "auto", "samples" or "ms"
+    static const juce::Identifier bufferAmount { "bufferAmount" };
+    static const juce::Identifier routing { "routing" };           // See RoutingMatrix::toString
+    static const juce::Identifier prefault { "prefault" };
+    static const juce::Identifier lockPages { "lockPages" };
+    static const juce::Identifier hugePages { "hugePages" };
+    static const juce::Identifier alignment { "alignment" };       // "fill", "clock" or "transport"
+}
+
 void AudioReceiverAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // The parameters' values, plus the settings that aren't parameters as properties.
+    auto state = parameters.copyState();
+    state.setProperty(StateIds::streamName, streamName, nullptr);
+
+    switch (jitterBuffer.getMode())
+    {
+        case JitterBuffer::Mode::automatic:         state.setProperty(StateIds::bufferMode, "auto", nullptr); break;
+        case JitterBuffer::Mode::fixedSamples:      state.setProperty(StateIds::bufferMode, "samples", nullptr); break;
+        case JitterBuffer::Mode::fixedMilliseconds: state.setProperty(StateIds::bufferMode, "ms", nullptr); break;
+    }
+
+    state.setProperty(StateIds::bufferAmount, jitterBuffer.getFixedAmount(), nullptr);
+    state.setProperty(StateIds::routing, juce::String(routingMatrix.toString()), nullptr);
+    state.setProperty(StateIds::prefault, mappingOptions.prefault, nullptr);
+    state.setProperty(StateIds::lockPages, mappingOptions.lockPages, nullptr);
+    state.setProperty(StateIds::hugePages, mappingOptions.hugePages, nullptr);
+
+    switch (getAlignment())
+    {
+        case Alignment::ringFill:       state.setProperty(StateIds::alignment, "fill", nullptr); break;
+        case Alignment::senderClock:    state.setProperty(StateIds::alignment, "clock", nullptr); break;
+        case Alignment::hostTransport:  state.setProperty(StateIds::alignment, "transport", nullptr); break;
+    }
+
+    if (auto xml = state.createXml())
+        copyXmlToBinary(*xml, destData);
 }
 
 void AudioReceiverAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    auto xml = getXmlFromBinary(data, sizeInBytes);
+
+    if (xml == nullptr)
+        return;
+
+    auto state = juce::ValueTree::fromXml(*xml);
+
+    if (!state.hasType(StateIds::root))
+        return;
+
+    // Parameters missing from the state (older sessions) keep their current values.
+    parameters.replaceState(state);
+
+    // Mapping options first, so a stream change below maps with them straight away.
+    const SharedConnection::MappingOptions defaults;
+    SharedConnection::MappingOptions options;
+    options.prefault = state.getProperty(StateIds::prefault, defaults.prefault);
+    options.lockPages = state.getProperty(StateIds::lockPages, defaults.lockPages);
+    options.hugePages = state.getProperty(StateIds::hugePages, defaults.hugePages);
+    setMappingOptions(options);
+
+    setStreamName(state.getProperty(StateIds::streamName, juce::String(SHARED_MEMORY_NAME)).toString());
+
+    const auto bufferMode = state.getProperty(StateIds::bufferMode, "auto").toString();
+    const double bufferAmount = state.getProperty(StateIds::bufferAmount, 512.0);
+
+    if (bufferMode == "samples")
+        jitterBuffer.setFixedSamples(bufferAmount);
+    else if (bufferMode == "ms")
+        jitterBuffer.setFixedMilliseconds(bufferAmount);
+    else
+        jitterBuffer.setAutomatic();
+
+    const auto alignmentName = state.getProperty(StateIds::alignment, "clock").toString();
+    setAlignment(alignmentName == "fill" ? Alignment::ringFill
+                 : alignmentName == "transport" ? Alignment::hostTransport : Alignment::senderClock);
+
+    // Older sessions have no routing and keep the default offset map.
+    if (state.hasProperty(StateIds::routing))
+        routingMatrix.fromString(state.getProperty(StateIds::routing).toString().toStdString());
 }
 
 //==============================================================================
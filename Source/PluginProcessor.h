@@ -2,6 +2,23 @@
 
 #include <JuceHeader.h>
 #include "SharedMemoryManager.h"
+#include "ChannelLevelMeter.h"
+#include "DriftController.h"
+#include "JitterBuffer.h"
+#include "RoutingMatrix.h"
+#include "FractionalResampler.h"
+#include "PolyphaseResampler.h"
+#include "UnderrunConcealer.h"
+#include "ReceiverMetrics.h"
+#include "AnchorTimeline.h"
+#include "TelemetryRing.h"
+#include "TelemetryCollector.h"
+#include "CaptureTap.h"
+#include "StreamDirectory.h"
+#include "StreamWatcher.h"
+#include "UdpReceiver.h"
+#include "SharedConnection.h"
+#include "ConnectionHandoff.h"
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -51,41 +68,272 @@ public:
     //New:
     bool isMemoryInitializedAndActive() const
     {
-        return isMemoryInitialized && sharedData != nullptr && sharedData->isActive.load();
+        auto* connection = connectionHandoff.getCurrent();
+        return isMemoryInitialized && connection != nullptr && connection->isSenderActive();
     }
     
     bool isConnectionActive() const
        {
-           return isMemoryInitialized && sharedData != nullptr && sharedData->isActive.load();
+           auto* connection = connectionHandoff.getCurrent();
+           return isMemoryInitialized && connection != nullptr && connection->isSenderActive();
        }
     
     double getCurrentLatency() const
         {
-            return isMemoryInitialized && sharedData != nullptr ?
-                   sharedData->metrics.currentLatency.load() : 0.0;
+            return isMemoryInitialized ? receiverMetrics.latencyMs.load() : 0.0;
         }
+
+    // Why the last connection attempt failed (e.g. "newer segment layout"); empty once connected.
+    juce::String getConnectionError() const { return lastConnectionError; }
     
     //New:
     bool attemptReconnection();  // For subsequent reconnection attempts
+
+    // Which sender stream this instance listens to: a shared-memory segment name, or "udp:<port>"
+    // to receive over the network (see UdpReceiver). Saved with the plugin state; changing it
+    // reconnects. Message thread only.
+    void setStreamName(const juce::String& newStreamName);
+    juce::String getStreamName() const { return streamName; }
+
+    // How new mappings are prepared before the audio thread reads them (pre-fault, mlock, huge
+    // pages). Saved with the plugin state; changing it remaps. Message thread only.
+    void setMappingOptions(const SharedConnection::MappingOptions& newOptions);
+    const SharedConnection::MappingOptions& getMappingOptions() const noexcept { return mappingOptions; }
+
+    // Which of those steps worked for the current mapping; empty when not connected.
+    SharedConnection::MappingReport getMappingReport() const
+    {
+        auto* connection = connectionHandoff.getCurrent();
+        return connection != nullptr ? connection->getMappingReport() : SharedConnection::MappingReport();
+    }
+
+    // Packet counters while receiving over UDP, null otherwise. Message thread.
+    const UdpReceiver::Stats* getUdpStats() const noexcept { return udpReceiver.isRunning() ? &udpReceiver.getStats() : nullptr; }
+
+    // Streams currently announced by senders in the discovery directory.
+    std::vector<StreamDirectory::StreamInfo> getAvailableStreams() const { return streamDirectory.listLiveStreams(); }
+
+    // Moves whenever a sender publishes or withdraws a stream, so the editor knows to re-list.
+    uint32_t getStreamListChangeCount() const noexcept { return streamWatcher.getChangeCount(); }
     
-    //Meter/gain stuff
-    float gain = 1.0f;           // Linear gain multiplier
-    float currentLevel = -60.0f; // Post-gain RMS level in dB
-    juce::CriticalSection levelLock;
+    // Host-automatable parameters: the output gain in dB (its bottom end is silence) and drift
+    // compensation. processBlock reads them lock-free; the other settings (stream, buffer, routing,
+    // mapping options) are kept as properties of the same state tree and saved along with them.
+    juce::AudioProcessorValueTreeState& getParameters() noexcept { return parameters; }
+    static constexpr const char* gainParameterId = "gain";
+    static constexpr const char* driftCompensationParameterId = "driftCompensation";
+    static constexpr float minGainDb = -60.0f;
+    static constexpr float maxGainDb = 12.0f;
+
+    // Post-gain per-channel peak/RMS, published wait-free from processBlock.
+    ChannelLevelMeter& getLevelMeter() noexcept { return levelMeter; }
+
+    // Drift/fill figures and receiver-side counters.
+    const ReceiverMetrics& getReceiverMetrics() const noexcept { return receiverMetrics; }
+
+    // Per-block timing, fill and gap history, aggregated into histograms in the background.
+    TelemetryCollector& getTelemetry() noexcept { return telemetryCollector; }
+
+    // Records the output to a WAV file (see CaptureTap). Message thread.
+    bool startCapture(const juce::File& file, juce::String& error);
+    CaptureTap& getCaptureTap() noexcept { return captureTap; }
+
+    // Receivers (including this one) currently reading the same stream. Message thread.
+    int getNumLiveReaders() const noexcept
+    {
+        auto* connection = connectionHandoff.getCurrent();
+        return connection != nullptr ? connection->getReaders().getNumLiveReaders() : 0;
+    }
+
+    // Which shared channels feed which output (copies, sums, mutes). Saved with the plugin state.
+    RoutingMatrix& getRoutingMatrix() noexcept { return routingMatrix; }
+
+    // Matrix rows for every output bus in order, and which of them the host has enabled. Each bus
+    // keeps its rows (and so its sources) whether or not the buses before it are enabled.
+    RoutingMatrix::OutputLayout describeOutputLayout() const;
+    // Samples per frame of the connected sender (the legacy layout's count when not connected).
+    int getNumSharedChannels() const noexcept
+    {
+        auto* connection = connectionHandoff.getCurrent();
+        return connection != nullptr ? connection->getNumChannels() : totalSharedChannels;
+    }
+    static constexpr int getNumDummyChannels() noexcept { return dummyChannels; }
+
+    // Target depth of the receive buffer (automatic or user-set). The resulting depth is reported
+    // to the host with setLatencySamples and written to the shared metrics.currentLatency.
+    JitterBuffer& getJitterBuffer() noexcept { return jitterBuffer; }
+
+    // Message thread: tells the host if the buffer depth changed since the last call.
+    void updateReportedLatency();
+
+    // When enabled (the default), the ring is read through a small resampler steered by the fill
+    // level, so sender/host clock drift is absorbed instead of causing periodic dropouts. A sender
+    // at a different sample rate is always converted, whether or not this is on.
+    void setDriftCompensationEnabled(bool shouldBeEnabled);
+    bool isDriftCompensationEnabled() const { return driftCompensationParameter->load() >= 0.5f; }
+
+    // What the read cursor is lined up with, given a sender that publishes time anchors (see
+    // SegmentHeader.h); the drift controller then holds it there:
+    //     ringFill       the target depth behind writeIndex, wherever the last resync left it
+    //     senderClock    the target depth behind the sender's timeline by the monotonic clock, so
+    //                    every instance reading a stream plays each frame at the same moment
+    //     hostTransport  the target depth behind the frame at our playhead's musical position,
+    //                    while both transports play and it is in the ring (senderClock otherwise)
+    // Senders without anchors (legacy and version 1 segments, UDP) always get ringFill, and so
+    // does offline rendering. Saved with the plugin state.
+    enum class Alignment { ringFill, senderClock, hostTransport };
+    void setAlignment(Alignment newAlignment) noexcept { alignment.store(newAlignment); }
+    Alignment getAlignment() const noexcept { return alignment.load(); }
 
 private:
+    // The state type matches the root of sessions saved before there were parameters, so they
+    // still load.
+    juce::AudioProcessorValueTreeState parameters { *this, nullptr, "AudioReceiverState", createParameterLayout() };
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    std::atomic<float>* gainParameter = nullptr;                // dB
+    std::atomic<float>* driftCompensationParameter = nullptr;   // 0 or 1
+
+    // Output gain, linear, ramped towards the parameter over a few milliseconds (audio thread).
+    // Applied by the de-interleave kernels as they copy, never as a pass of its own.
+    juce::SmoothedValue<float> outputGain { 1.0f };
+    RingDeinterleave::GainRamp nextGainRamp(int numSamples, int numFrames) noexcept;
     
     // Flag to indicate if we can write to the shared memory
     bool canWriteToSharedMemory = false;
+
+    juce::String streamName { SHARED_MEMORY_NAME };
+    juce::String lastConnectionError;
+    StreamDirectory streamDirectory;
+    SharedConnection::MappingOptions mappingOptions;
+
+    // Wakes us when a sender announces a stream, so we connect within milliseconds of it coming
+    // up. Senders that don't announce themselves (AudioSender) are still found by the
+    // reconnection timer's shm_open probe on every tick while disconnected.
+    StreamWatcher streamWatcher { streamDirectory };
+    uint64_t connectedStreamOwner = 0;   // Directory owner of the stream we last connected to
+
+    bool handleStreamsChanged();
+
+    // Network transport: writes received packets into a local segment, which we then map like a
+    // sender's. Running only while the stream name is "udp:<port>".
+    UdpReceiver udpReceiver;
+    uint32_t connectedUdpGeneration = 0;   // The receiver's segment generation we last mapped
     
     uint64_t lastReadIndex = 0;
+    uint64_t observedWriteIndex = 0;   // The sender's writeIndex as last loaded (audio thread)
+
+    // Legacy shared memory contains 10 channels, the first two of which are unused. Self-describing
+    // segments say how many they carry; the dummies are assumed to be there too.
+    static constexpr int totalSharedChannels = SharedConnection::legacyNumChannels;
+    static constexpr int dummyChannels = 2;
+
+    // Routing (matrix edited on the message thread, plan and scratch owned by the audio thread)
+    RoutingMatrix routingMatrix;
+    RoutingMatrix::Plan routingPlan;
+    RoutingMatrix::OutputLayout outputLayout; // Set in prepareToPlay
+    juce::AudioBuffer<float> routingScratch;
+    void readRouted(const SharedConnection& shared, float* const* dest, int numOutputs, int numFrames,
+                    RingDeinterleave::ChannelStats* stats, const RingDeinterleave::GainRamp& gain);
+
+    void processSubBlock(SharedConnection& connection, juce::AudioBuffer<float>& buffer, int offset, uint64_t earliestFrame,
+                         bool forceResync, TelemetryRing::Record& telemetry);
+
+    int readIntoBuffer(const SharedConnection& shared, juce::AudioBuffer<float>& buffer, int inputFrames, int outputFrames,
+                       bool useResampler, double ratio, RingDeinterleave::ChannelStats* stats,
+                       const RingDeinterleave::GainRamp& gain);
+
+    // Fades dropouts out and back in (audio thread, set up in prepareToPlay)
+    UnderrunConcealer concealer;
+
+    // Sample encoding of the frames being read this block (see SampleFormat.h)
+    SampleFormat::Encoding ringEncoding = SampleFormat::float32;
+    void readSharedChannels(const SharedConnection& shared, int firstSource, uint64_t readIndex, int numFrames,
+                            float* const* dest, int numDest, RingDeinterleave::ChannelStats* stats,
+                            const RingDeinterleave::GainRamp& gain = {});
+
+    ChannelLevelMeter levelMeter;
+    ReceiverMetrics receiverMetrics;
+    TelemetryRing telemetryRing;
+    TelemetryCollector telemetryCollector { telemetryRing };
+    CaptureTap captureTap;
+
+    // Drift compensation (audio thread state, set up in prepareToPlay)
+    JitterBuffer jitterBuffer;
+    DriftController driftController;
+    FractionalResampler resampler;
+    bool readCursorPrimed = false; // False until the ring holds the target fill after a start or underrun
+
+    // Offline rendering: how long a sub-block waits for the sender before concealing instead. Once
+    // a wait runs out we don't wait again until writeIndex moves, so a sender that has stopped
+    // costs one timeout rather than one per block.
+    static constexpr double offlineWaitTimeoutMs = 1000.0;
+    bool offlineSenderStalled = false;
+    uint64_t offlineStallWriteIndex = 0;
+    double currentSampleRate = 48000.0;
+
+    // Timeline alignment (audio thread, see Alignment). The host timeline follows our own blocks
+    // against the clock, so the time we take for "now" doesn't jitter with the callback.
+    std::atomic<Alignment> alignment { Alignment::senderClock };
+    AnchorTimeline senderTimeline;            // In sender frames
+    AnchorTimeline hostTimeline;              // In host samples
+    uint64_t lastAnchorSequence = 0;
+    SegmentLayout::Anchor senderTransport;    // The latest anchor, for its musical position
+    uint64_t hostSamplePosition = 0;
+    int64_t blockClockNs = 0;                 // This block's start by the host timeline
+    double blockPpq = 0.0, blockBpm = 0.0;    // Our playhead at the block's start; NaN and 0 while stopped
+
+    // A cursor further than this from where the anchors put it is moved there rather than
+    // steered (transport relocate, switching modes): the drift controller would take minutes.
+    static constexpr double realignAfterMs = 10.0;
+
+    struct TimelinePosition
+    {
+        double clockFrame = std::numeric_limits<double>::quiet_NaN();      // Sender frame due now by the clock
+        double transportFrame = std::numeric_limits<double>::quiet_NaN();  // Sender frame at our playhead
+        double alignedFrame = std::numeric_limits<double>::quiet_NaN();    // The one to line up with; NaN for ringFill
+        Alignment alignedTo = Alignment::ringFill;
+    };
+
+    void updateTimelines(const SharedConnection& connection, int numSamples);
+    TimelinePosition locateTimeline(int offset, uint64_t writeIndex, uint64_t ringCapacity) const noexcept;
+
+    // Sample-rate conversion for a sender running at another rate (audio thread). Takes over from
+    // the drift resampler while the rates differ, with the drift correction folded into its ratio.
+    PolyphaseResampler rateConverter;
+    double conversionRatio = 1.0; // Sender rate over host rate; 1 when they match or the sender doesn't say
+
+    bool updateConversion(double senderSampleRate);
+    int resamplerInputFramesNeeded(int numOutput, double ratio) const noexcept;
+    int resamplerOutputFramesFor(int numInput, double ratio) const noexcept;
+    int resamplerMaxOutputFrames() const noexcept;
+    void resetResamplers() noexcept;
+
+    // The live mapping. Built and torn down on the message thread, picked up by the audio thread
+    // at the start of each block; a replaced mapping is only unmapped once the audio thread has
+    // moved on, so reconnecting never blocks or pulls memory out from under processBlock.
+    ConnectionHandoff<SharedConnection> connectionHandoff;
+    uint64_t audioThreadConnectionId = 0; // Audio thread: the connection our read state belongs to
+
+    // Mirroring the slowest reader into the shared readIndex (see publishReadIndex)
+    uint64_t legacyReadIndex = 0;
+    int blocksSinceLegacyMirror = 0;
+    static constexpr int legacyMirrorInterval = 8;
+
+    void resyncReadIndex(SharedConnection& connection, uint64_t referenceFrame, uint64_t earliestFrame);
+    void publishReadIndex(SharedConnection& connection);
+    void adoptConnection(std::unique_ptr<SharedConnection> connection);
+    void disconnectFromSharedMemory();
 
     // Timer for reconnection attempts
     class ReconnectionTimer : public juce::Timer
         {
         public:
             ReconnectionTimer(AudioReceiverAudioProcessor& processor) : owner(processor) {}
-            void timerCallback() override { owner.attemptReconnection(); }
+            void timerCallback() override
+            {
+                owner.attemptReconnection();
+                owner.updateReportedLatency();
+            }
         private:
             AudioReceiverAudioProcessor& owner;
         };
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define POLYPHASE_RESAMPLER_SSE 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define POLYPHASE_RESAMPLER_NEON 1
+#endif
+
+// Sample-rate converter for a sender running at a different rate from the host (44.1 kHz against
+// 48 kHz and the like). Same interface as FractionalResampler, so the processor can swap it in:
+// input frames are written to getInputPointers(), process() produces the output block.
+//
+// A Kaiser-windowed sinc of numTaps input frames, tabulated at numPhases fractional offsets (plus
+// one, so neighbouring rows can be blended linearly for the exact offset). design() places the
+// cutoff just under the lower of the two Nyquist rates, so downsampling doesn't alias. Each row is
+// normalised to unity gain at DC, which keeps the phase blend free of level ripple.
+//
+// History is kept interleaved, each frame padded to a multiple of four channels. Per output frame
+// the kernel is blended once, then every tap is one broadcast multiply-add over all channels at
+// once (SSE2 or NEON, four channels per register), with no horizontal sums.
+//
+// The kernel is centred, so output lags input by halfTaps input frames; getLatencyFrames() reports
+// that for setLatencySamples. Storage is sized in prepare() and design() only refills the table,
+// so neither process() nor design() allocates.
+class PolyphaseResampler
+{
+public:
+    static constexpr int numTaps = 64;
+    static constexpr int halfTaps = numTaps / 2;
+    static constexpr int numPhases = 128;
+    static constexpr int maxChannels = 32;
+    static constexpr double maxConversion = 4.0;    // Sender/host rate ratios from 1/4 to 4
+
+    // Message thread. maxOutput is the largest block process() will be asked for, maxRatio the
+    // largest ratio it will be given (conversion and drift correction together).
+    void prepare (int numChannels, int maxOutput, double maxRatio)
+    {
+        channels = std::clamp (numChannels, 1, maxChannels);
+        stride = (channels + 3) & ~3;
+        maxOutputFrames = maxOutput;
+        maxInputFrames = (int) std::ceil ((double) maxOutput * maxRatio) + numTaps + 4;
+        capacity = numTaps + maxInputFrames;
+
+        history.assign ((size_t) (capacity * stride), 0.0f);
+        staging.assign ((size_t) (channels * maxInputFrames), 0.0f);
+        inputPointers.resize ((size_t) channels);
+        table.assign ((size_t) ((numPhases + 1) * numTaps), 0.0f);
+
+        for (int ch = 0; ch < channels; ++ch)
+            inputPointers[(size_t) ch] = staging.data() + (size_t) (ch * maxInputFrames);
+
+        design (designedRatio);
+    }
+
+    // Audio thread, bounded time: fills the kernel table for a conversion ratio (sender rate over
+    // host rate) and starts over.
+    void design (double conversionRatio) noexcept
+    {
+        designedRatio = conversionRatio;
+
+        // Cutoff in cycles per input frame, a little under the lower Nyquist rate so the window's
+        // transition band ends close to it.
+        const double cutoff = 0.455 * std::min (1.0, 1.0 / conversionRatio);
+        const double beta = 8.0;
+        const double windowNorm = 1.0 / besselI0 (beta);
+        const double pi = 3.14159265358979323846;
+
+        for (int phase = 0; phase <= numPhases; ++phase)
+        {
+            float* row = table.data() + (size_t) (phase * numTaps);
+            const double offset = (double) phase / (double) numPhases;
+            double sum = 0.0;
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                // Distance from the output position to input tap k, in input frames.
+                const double t = (double) (k - (halfTaps - 1)) - offset;
+                const double x = 2.0 * cutoff * t;
+                const double sinc = std::abs (x) < 1.0e-12 ? 1.0 : std::sin (pi * x) / (pi * x);
+                const double edge = t / (double) halfTaps;
+                const double window = edge * edge < 1.0 ? besselI0 (beta * std::sqrt (1.0 - edge * edge)) * windowNorm : 0.0;
+
+                const double h = sinc * window;
+                row[k] = (float) h;
+                sum += h;
+            }
+
+            for (int k = 0; k < numTaps; ++k)
+                row[k] = (float) ((double) row[k] / sum);
+        }
+
+        reset();
+    }
+
+    // Drops all history; the next output starts on the first new input frame.
+    void reset() noexcept
+    {
+        std::fill (history.begin(), history.end(), 0.0f);
+        validFrames = halfTaps;    // Silence stands in for the frames before the stream
+        position = (double) halfTaps;
+    }
+
+    int getNumChannels() const noexcept       { return channels; }
+    int getMaxOutputFrames() const noexcept   { return maxOutputFrames; }
+    double getDesignedRatio() const noexcept  { return designedRatio; }
+
+    // Group delay, in input frames.
+    static constexpr int getLatencyFrames() noexcept   { return halfTaps; }
+
+    // How many new input frames process() needs to produce numOutput frames at this ratio.
+    int getInputFramesNeeded (int numOutput, double ratio) const noexcept
+    {
+        const double lastPosition = position + (double) (numOutput - 1) * ratio;
+        const int needed = (int) lastPosition + halfTaps + 1 - validFrames;
+        return std::max (0, needed);
+    }
+
+    // The most output frames numInput new frames are enough for at this ratio.
+    int getOutputFramesFor (int numInput, double ratio) const noexcept
+    {
+        const double lastUsable = (double) (validFrames + numInput - halfTaps - 1);
+
+        if (lastUsable < position)
+            return 0;
+
+        int frames = (int) ((lastUsable - position) / ratio) + 1;
+
+        while (frames > 0 && getInputFramesNeeded (frames, ratio) > numInput)
+            --frames;
+
+        return frames;
+    }
+
+    // Where the next numNew input frames must be written (planar) before calling process().
+    float* const* getInputPointers() noexcept   { return inputPointers.data(); }
+
+    // numNew must be getInputFramesNeeded (numOutput, ratio) and numOutput <= getMaxOutputFrames().
+    // Only the first numOutputChannels channels are written to output.
+    void process (int numNew, float* const* output, int numOutputChannels, int numOutput, double ratio) noexcept
+    {
+        appendInput (numNew);
+
+        const int outputChannels = std::min (channels, numOutputChannels);
+        double pos = position;
+
+        for (int i = 0; i < numOutput; ++i)
+        {
+            const int n = (int) pos;
+            blendKernel (pos - (double) n);
+
+            alignas (16) float frame[maxChannels];
+            convolve (history.data() + (size_t) ((n - (halfTaps - 1)) * stride), frame);
+
+            for (int ch = 0; ch < outputChannels; ++ch)
+                output[ch][i] = frame[ch];
+
+            pos += ratio;
+        }
+
+        // Keep everything the next output position's kernel reaches back to.
+        const int keepFrom = std::min ((int) pos - (halfTaps - 1), validFrames);
+
+        if (keepFrom > 0)
+        {
+            std::memmove (history.data(), history.data() + (size_t) (keepFrom * stride),
+                          sizeof (float) * (size_t) ((validFrames - keepFrom) * stride));
+            validFrames -= keepFrom;
+        }
+
+        position = pos - (double) keepFrom;
+    }
+
+private:
+    void appendInput (int numNew) noexcept
+    {
+        float* dest = history.data() + (size_t) (validFrames * stride);
+
+        for (int i = 0; i < numNew; ++i, dest += stride)
+            for (int ch = 0; ch < channels; ++ch)
+                dest[ch] = inputPointers[(size_t) ch][i];
+
+        validFrames += numNew;
+    }
+
+    // The kernel for an output position `fraction` past an input frame: two table rows, blended.
+    void blendKernel (double fraction) noexcept
+    {
+        const double phase = fraction * (double) numPhases;
+        const int row = std::min ((int) phase, numPhases - 1);
+        const float t = (float) (phase - (double) row);
+        const float* a = table.data() + (size_t) (row * numTaps);
+        const float* b = a + numTaps;
+
+        for (int k = 0; k < numTaps; ++k)
+            kernel[k] = a[k] + t * (b[k] - a[k]);
+    }
+
+    // One output frame: the kernel applied to numTaps interleaved frames starting at `first`.
+    void convolve (const float* first, float* frame) const noexcept
+    {
+        const int groups = stride / 4;
+
+       #if POLYPHASE_RESAMPLER_SSE
+        __m128 acc[maxChannels / 4];
+
+        for (int g = 0; g < groups; ++g)
+            acc[g] = _mm_setzero_ps();
+
+        for (int k = 0; k < numTaps; ++k, first += stride)
+        {
+            const __m128 c = _mm_set1_ps (kernel[k]);
+
+            for (int g = 0; g < groups; ++g)
+                acc[g] = _mm_add_ps (acc[g], _mm_mul_ps (c, _mm_loadu_ps (first + 4 * g)));
+        }
+
+        for (int g = 0; g < groups; ++g)
+            _mm_store_ps (frame + 4 * g, acc[g]);
+       #elif POLYPHASE_RESAMPLER_NEON
+        float32x4_t acc[maxChannels / 4];
+
+        for (int g = 0; g < groups; ++g)
+            acc[g] = vdupq_n_f32 (0.0f);
+
+        for (int k = 0; k < numTaps; ++k, first += stride)
+            for (int g = 0; g < groups; ++g)
+                acc[g] = vmlaq_n_f32 (acc[g], vld1q_f32 (first + 4 * g), kernel[k]);
+
+        for (int g = 0; g < groups; ++g)
+            vst1q_f32 (frame + 4 * g, acc[g]);
+       #else
+        std::fill (frame, frame + stride, 0.0f);
+
+        for (int k = 0; k < numTaps; ++k, first += stride)
+            for (int ch = 0; ch < stride; ++ch)
+                frame[ch] += kernel[k] * first[ch];
+       #endif
+    }
+
+    static double besselI0 (double x) noexcept
+    {
+        // Power series; converges to float precision well within 32 terms for beta <= 10.
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x * 0.5 / (double) k) * (x * 0.5 / (double) k);
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    int channels = 0;
+    int stride = 4;
+    int capacity = 0;
+    int maxOutputFrames = 0;
+    int maxInputFrames = 0;
+    int validFrames = halfTaps;
+    double position = (double) halfTaps;
+    double designedRatio = 1.0;
+
+    std::vector<float> history;     // capacity frames x stride, interleaved
+    std::vector<float> staging;     // Planar input for the next process()
+    std::vector<float*> inputPointers;
+    std::vector<float> table;       // (numPhases + 1) rows of numTaps
+    alignas (16) float kernel[numTaps] {};
+};
@@ -0,0 +1,238 @@
+#include "ReaderRegistry.h"
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // Distinguishes several receivers inside one host process (they share a pid).
+    std::atomic<uint32_t> nextInstanceId { 1 };
+}
+
+ReaderRegistry::ReaderRegistry()
+{
+    token = ((uint64_t) (uint32_t) getpid() << 32) | nextInstanceId.fetch_add(1);
+}
+
+ReaderRegistry::~ReaderRegistry()
+{
+    detach();
+}
+
+bool ReaderRegistry::attach(const std::string& streamName)
+{
+    detach();
+
+    streamSegmentName = streamName;
+    segmentName = streamName + "_rd";
+
+    // Either side may create the table; a freshly created segment is zero-filled, which is a valid
+    // empty table.
+    fd = shm_open(segmentName.c_str(), O_RDWR | O_CREAT, 0666);
+
+    if (fd == -1)
+        return false;
+
+    struct stat info {};
+    if (fstat(fd, &info) == -1
+        || ((size_t) info.st_size < sizeof(ReaderTableLayout::Table)
+            && ftruncate(fd, (off_t) sizeof(ReaderTableLayout::Table)) == -1))
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(ReaderTableLayout::Table), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mapped == MAP_FAILED)
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    auto* newTable = static_cast<ReaderTableLayout::Table*>(mapped);
+
+    // Stamp an empty table; refuse one written by an incompatible build.
+    uint32_t expected = 0;
+    if (! newTable->tableMagic.compare_exchange_strong(expected, ReaderTableLayout::magic))
+    {
+        if (expected != ReaderTableLayout::magic)
+        {
+            munmap(mapped, sizeof(ReaderTableLayout::Table));
+            close(fd);
+            fd = -1;
+            return false;
+        }
+    }
+
+    if (newTable->tableVersion.load() == 0)
+        newTable->tableVersion.store(ReaderTableLayout::version);
+
+    if (newTable->tableVersion.load() != ReaderTableLayout::version)
+    {
+        munmap(mapped, sizeof(ReaderTableLayout::Table));
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    table = newTable;
+    reapDeadReaders();
+    return claimSlot();
+}
+
+void ReaderRegistry::detach()
+{
+    releaseSlot();
+
+    if (table != nullptr)
+    {
+        // The sender maps the table too, so it stays while the sender is up. Once the stream is
+        // gone and we were the last reader, nobody else will remove it.
+        if (table->activeMask.load(std::memory_order_acquire) == 0 && !streamSegmentExists())
+            shm_unlink(segmentName.c_str());
+
+        munmap(table, sizeof(ReaderTableLayout::Table));
+        table = nullptr;
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool ReaderRegistry::claimSlot()
+{
+    if (table == nullptr)
+        return false;
+
+    for (int i = 0; i < ReaderTableLayout::maxReaders; ++i)
+    {
+        auto& candidate = table->slots[i];
+        uint64_t expected = 0;
+
+        if (candidate.owner.compare_exchange_strong(expected, token))
+        {
+            // Start with an expired lease so we don't count towards the minimum before our
+            // first real cursor arrives.
+            candidate.cursor.store(0, std::memory_order_relaxed);
+            candidate.supportedEncodings.store(SampleFormat::allEncodings, std::memory_order_relaxed);
+            candidate.heartbeatMs.store(0, std::memory_order_release);
+            table->activeMask.fetch_or(uint64_t(1) << i, std::memory_order_acq_rel);
+
+            slotLost.store(false);
+            slot.store(&candidate, std::memory_order_release);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReaderRegistry::releaseSlot()
+{
+    auto* s = slot.exchange(nullptr);
+
+    if (s == nullptr || table == nullptr)
+        return;
+
+    // If the slot was reclaimed from us, whoever did that already cleared its bit.
+    if (s->owner.load() == token)
+        freeSlot((int) (s - table->slots), token);
+}
+
+// The mask bit has to go before the owner: once the owner is 0, another receiver can claim the
+// slot and set the bit, and a late fetch_and would hide that live reader from minimumCursor().
+// If the slot turns out to be owned by someone else afterwards, their bit is put back.
+void ReaderRegistry::freeSlot(int index, uint64_t owner)
+{
+    const uint64_t bit = uint64_t(1) << index;
+    auto& s = table->slots[index];
+
+    table->activeMask.fetch_and(~bit, std::memory_order_acq_rel);
+
+    s.owner.compare_exchange_strong(owner, 0);
+
+    if (s.owner.load() != 0)
+        table->activeMask.fetch_or(bit, std::memory_order_acq_rel);
+}
+
+bool ReaderRegistry::streamSegmentExists() const
+{
+    const int streamFd = shm_open(streamSegmentName.c_str(), O_RDONLY, 0);
+
+    if (streamFd == -1)
+        return errno != ENOENT;
+
+    close(streamFd);
+    return true;
+}
+
+bool ReaderRegistry::isProcessAlive(uint64_t owner)
+{
+    const pid_t pid = (pid_t) (owner >> 32);
+
+    // EPERM means the process exists but belongs to someone else.
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+void ReaderRegistry::reapDeadReaders()
+{
+    if (table == nullptr)
+        return;
+
+    const uint64_t now = ReaderTableLayout::nowMs();
+
+    for (int i = 0; i < ReaderTableLayout::maxReaders; ++i)
+    {
+        auto& candidate = table->slots[i];
+        uint64_t owner = candidate.owner.load();
+
+        if (owner == 0 || owner == token)
+            continue;
+
+        const uint64_t heartbeat = candidate.heartbeatMs.load();
+        const bool abandoned = heartbeat != 0 && now > heartbeat && now - heartbeat > ReaderTableLayout::abandonMs;
+
+        if (! isProcessAlive(owner) || abandoned)
+            freeSlot(i, owner);
+    }
+
+    // Someone reclaimed our slot while we were stalled; take a fresh one.
+    if (slotLost.exchange(false))
+    {
+        slot.store(nullptr, std::memory_order_release);
+        claimSlot();
+    }
+}
+
+int ReaderRegistry::getNumLiveReaders() const noexcept
+{
+    if (table == nullptr)
+        return 0;
+
+    const uint64_t now = ReaderTableLayout::nowMs();
+    uint64_t mask = table->activeMask.load(std::memory_order_acquire);
+    int count = 0;
+
+    for (int i = 0; i < ReaderTableLayout::maxReaders; ++i)
+    {
+        if ((mask & (uint64_t(1) << i)) == 0)
+            continue;
+
+        const uint64_t heartbeat = table->slots[i].heartbeatMs.load(std::memory_order_relaxed);
+
+        if (now <= heartbeat || now - heartbeat <= ReaderTableLayout::leaseMs)
+            ++count;
+    }
+
+    return count;
+}
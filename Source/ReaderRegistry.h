@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SampleFormat.h"
+
+// Reader registration table for fanning one sender out to several receivers.
+//
+// SharedAudioData has a single readIndex, so two receivers on the same stream used to overwrite
+// each other's cursor. The table lives in a small companion segment next to the audio segment
+// (named "<stream>_rd") and gives every receiver its own slot:
+//   - each slot sits on its own 64-byte cache line and is only written by its owner, so N readers
+//     publish their cursors without touching each other's lines
+//   - the owner refreshes a heartbeat with every cursor update; minimumCursor() ignores slots whose
+//     lease has expired, so a stalled or crashed reader never holds the sender back
+//   - slots whose owning process has died are freed by reapDeadReaders()
+//   - the table is unlinked by whoever leaves last: the sender if no reader is attached when it
+//     closes, otherwise the last reader to detach after the stream's segment has gone
+//   - each slot lists the sample encodings its reader can decode, and the table header holds the
+//     encoding the sender is writing and the frame it started at (see SampleFormat.h). Both fields
+//     were zero in tables from older builds, which reads as "float32 only" and "float32 from the
+//     start", so the layout version didn't change
+// All-zero memory is a valid empty table, so whichever side creates the segment first needs no
+// initialisation beyond ftruncate.
+//
+// The header only depends on the standard library so the sender can include it and call
+// minimumCursor() on its own mapping.
+namespace ReaderTableLayout
+{
+    static constexpr uint32_t magic = 0x41525254;   // 'ARRT'
+    static constexpr uint32_t version = 1;
+    static constexpr int maxReaders = 32;
+    static constexpr uint64_t leaseMs = 500;         // Heartbeat age after which a reader stops counting
+    static constexpr uint64_t abandonMs = 60000;     // Heartbeat age after which a slot is reclaimed anyway
+
+    struct alignas (64) Slot
+    {
+        std::atomic<uint64_t> owner { 0 };           // 0 = free, otherwise (pid << 32) | per-process instance
+        std::atomic<uint64_t> cursor { 0 };          // Next frame this reader will read
+        std::atomic<uint64_t> heartbeatMs { 0 };     // Monotonic milliseconds of the last cursor update
+        std::atomic<uint32_t> supportedEncodings { 0 }; // SampleFormat mask; float32 is implied
+    };
+
+    struct Table
+    {
+        alignas (64) std::atomic<uint32_t> tableMagic { 0 };
+        std::atomic<uint32_t> tableVersion { 0 };
+        std::atomic<uint64_t> activeMask { 0 };      // Bit i set while slot i is owned
+        std::atomic<uint64_t> ringFormat { 0 };      // Sender's encoding << encodingShift | its first frame
+
+        Slot slots[maxReaders];
+    };
+
+    static_assert (sizeof (Slot) == 64, "Reader slots must each fill exactly one cache line");
+    static_assert (offsetof (Table, slots) == 64, "New header fields must not move the slots");
+
+    //==============================================================================
+    // The ring's sample encoding, packed into one word so a reader never sees an encoding with the
+    // wrong starting frame. Frames before firstFrame are in whatever encoding came before.
+    static constexpr int encodingShift = 56;
+
+    struct RingFormat
+    {
+        SampleFormat::Encoding encoding = SampleFormat::float32;
+        uint64_t firstFrame = 0;
+    };
+
+    // The packing is shared with the self-describing segment header (SegmentHeader.h).
+    inline uint64_t packRingFormat (SampleFormat::Encoding encoding, uint64_t firstFrame) noexcept
+    {
+        return (uint64_t) encoding << encodingShift | (firstFrame & ((uint64_t (1) << encodingShift) - 1));
+    }
+
+    inline RingFormat unpackRingFormat (uint64_t packed) noexcept
+    {
+        return { (SampleFormat::Encoding) (packed >> encodingShift), packed & ((uint64_t (1) << encodingShift) - 1) };
+    }
+
+    inline RingFormat loadRingFormat (const Table& table) noexcept
+    {
+        return unpackRingFormat (table.ringFormat.load (std::memory_order_acquire));
+    }
+
+    // Sender side: frames from firstFrame on are written in `encoding`. Publish before writing them.
+    inline void storeRingFormat (Table& table, SampleFormat::Encoding encoding, uint64_t firstFrame) noexcept
+    {
+        table.ringFormat.store (packRingFormat (encoding, firstFrame), std::memory_order_release);
+    }
+
+    inline uint64_t nowMs() noexcept
+    {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds> (
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Lowest cursor among readers with a live lease. Returns false when nobody is reading, in
+    // which case the sender may free-run. This is the sender's flow-control view.
+    inline bool minimumCursor (const Table& table, uint64_t now, uint64_t& result) noexcept
+    {
+        uint64_t mask = table.activeMask.load (std::memory_order_acquire);
+        bool found = false;
+
+        while (mask != 0)
+        {
+            int index = 0;
+            while ((mask & (uint64_t (1) << index)) == 0)
+                ++index;
+
+            mask &= ~(uint64_t (1) << index);
+
+            const Slot& slot = table.slots[index];
+            const uint64_t heartbeat = slot.heartbeatMs.load (std::memory_order_acquire);
+
+            if (now > heartbeat && now - heartbeat > leaseMs)
+                continue;
+
+            const uint64_t cursor = slot.cursor.load (std::memory_order_acquire);
+
+            if (! found || cursor < result)
+                result = cursor;
+
+            found = true;
+        }
+
+        return found;
+    }
+
+    // Encodings every reader with a live lease can decode. With nobody reading, any encoding will do.
+    inline uint32_t commonEncodings (const Table& table, uint64_t now) noexcept
+    {
+        uint64_t mask = table.activeMask.load (std::memory_order_acquire);
+        uint32_t common = SampleFormat::allEncodings;
+
+        for (int index = 0; index < maxReaders; ++index)
+        {
+            if ((mask & (uint64_t (1) << index)) == 0)
+                continue;
+
+            const Slot& slot = table.slots[index];
+            const uint64_t heartbeat = slot.heartbeatMs.load (std::memory_order_acquire);
+
+            if (now > heartbeat && now - heartbeat > leaseMs)
+                continue;
+
+            common &= slot.supportedEncodings.load (std::memory_order_relaxed) | SampleFormat::maskOf (SampleFormat::float32);
+        }
+
+        return common;
+    }
+}
+
+//==============================================================================
+// Receiver-side handle on the table: maps the companion segment, owns one slot.
+class ReaderRegistry
+{
+public:
+    ReaderRegistry();
+    ~ReaderRegistry();
+
+    // Message thread. Creates the companion segment if needed and claims a slot. detach() unlinks
+    // it again when we were the last reader of a stream that no longer exists.
+    bool attach (const std::string& streamName);
+    void detach();
+
+    bool isAttached() const noexcept                  { return table != nullptr; }
+    bool hasSlot() const noexcept                     { return slot.load() != nullptr; }
+
+    // Message thread, about once a second: frees slots left behind by crashed readers and
+    // re-claims our own slot if someone reclaimed it while we were stalled.
+    void reapDeadReaders();
+
+    // Audio thread: publish our cursor and refresh the lease. Wait-free.
+    void publishCursor (uint64_t cursor) noexcept
+    {
+        auto* s = slot.load (std::memory_order_acquire);
+
+        if (s == nullptr)
+            return;
+
+        // If the slot was reclaimed (we were stalled for abandonMs), stop writing to it and let
+        // the message thread claim a new one.
+        if (s->owner.load (std::memory_order_relaxed) != token)
+        {
+            slotLost.store (true, std::memory_order_relaxed);
+            return;
+        }
+
+        s->cursor.store (cursor, std::memory_order_release);
+        s->heartbeatMs.store (ReaderTableLayout::nowMs(), std::memory_order_release);
+
+        // Another receiver may have reclaimed the slot between the check and the stores, in which
+        // case we just wrote our stale cursor over its fresh claim until its own next publish.
+        // Look again (the fence keeps the load after the stores) so we stop writing there from
+        // the next block on and the message thread claims us a new slot.
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+
+        if (s->owner.load (std::memory_order_relaxed) != token)
+            slotLost.store (true, std::memory_order_relaxed);
+    }
+
+    // Lowest live cursor across all readers, including ours.
+    bool getMinimumCursor (uint64_t& result) const noexcept
+    {
+        return table != nullptr && ReaderTableLayout::minimumCursor (*table, ReaderTableLayout::nowMs(), result);
+    }
+
+    int getNumLiveReaders() const noexcept;
+
+    // Audio thread: the encoding the sender is writing and where it began. Float32 from frame 0
+    // without a table.
+    ReaderTableLayout::RingFormat getRingFormat() const noexcept
+    {
+        return table != nullptr ? ReaderTableLayout::loadRingFormat (*table) : ReaderTableLayout::RingFormat();
+    }
+
+private:
+    bool claimSlot();
+    void releaseSlot();
+    void freeSlot (int index, uint64_t owner);
+    bool streamSegmentExists() const;
+    static bool isProcessAlive (uint64_t owner);
+
+    std::string streamSegmentName;
+    std::string segmentName;
+    int fd = -1;
+    ReaderTableLayout::Table* table = nullptr;
+    std::atomic<ReaderTableLayout::Slot*> slot { nullptr };
+    uint64_t token = 0;
+    std::atomic<bool> slotLost { false };
+};
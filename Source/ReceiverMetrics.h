@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Receiver-side counterpart of the sender's shared `metrics` block.
+//
+// SharedAudioData::metrics belongs to the sender (it owns the layout in SharedMemoryManager.h), so
+// figures only the receiver knows about live here. Everything is written from the audio thread
+// with relaxed stores and may be read from any thread.
+struct ReceiverMetrics
+{
+    // Clock-drift compensation
+    std::atomic<double> resampleRatio { 1.0 };  // Input frames consumed per output frame
+    std::atomic<double> driftPpm { 0.0 };       // Estimated sender/receiver clock mismatch
+    std::atomic<double> fillLevel { 0.0 };      // Smoothed ring fill, in frames
+    std::atomic<double> targetFill { 0.0 };     // Fill the drift controller steers towards (the jitter buffer depth)
+    std::atomic<double> latencyMs { 0.0 };      // Audio actually buffered ahead of us, as written to metrics.currentLatency
+    std::atomic<uint32_t> ringEncoding { 0 };   // SampleFormat::Encoding the sender is writing
+
+    // Sample-rate conversion
+    std::atomic<double> senderSampleRate { 0.0 };   // As the sender's segment states it; 0 if it doesn't (legacy layout)
+    std::atomic<double> conversionRatio { 1.0 };    // Sender rate over host rate; 1 when no conversion is running
+
+    // Timeline alignment (see AudioReceiverAudioProcessor::Alignment)
+    std::atomic<uint32_t> alignedTo { 0 };          // What the read cursor followed last block: 0 ring fill, 1 sender clock, 2 host transport
+    std::atomic<double> timelineOffsetMs { 0.0 };   // How far behind the sender's clock the frames being read are; 0 without anchors
+    std::atomic<double> transportOffsetMs { 0.0 };  // Our playhead minus the sender's position of the frames being read; 0 unless both play
+
+    std::atomic<uint64_t> bufferUnderruns { 0 }; // Blocks that could not be filled (also counted in the shared metrics)
+    std::atomic<uint64_t> resyncs { 0 };         // Hard read-cursor jumps (sender restart or overrun)
+    std::atomic<uint64_t> concealments { 0 };    // Dropouts faded out instead of cut (see UnderrunConcealer)
+    std::atomic<uint64_t> concealedBlocks { 0 }; // Blocks holding any concealed or faded-in audio
+};
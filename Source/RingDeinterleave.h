@@ -0,0 +1,653 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// De-interleave kernels for the shared-memory ring.
+//
+// The sender writes frames of `stride` interleaved floats into a power-of-two ring. The receiver
+// needs a run of consecutive channels out of each frame, written into planar output channels.
+// A read of N frames starting at `readIndex` is split at the BUFFER_MASK wraparound into at most
+// two contiguous spans, and each span is copied with a transpose kernel:
+//   - AVX:  8 frames x 8 channels per 8x8 transpose (falls back to 4x4 for the channel remainder)
+//   - SSE:  4 frames x 4 channels per 4x4 transpose
+//   - NEON: 4 frames x 4 channels per 4x4 transpose
+//   - all three: 4 frames x 2 channels per pair shuffle, for a channel pair left over after the
+//     groups of four (stereo is nothing but that pair)
+//   - anything else: plain scalar copy straight into the planar pointers
+// The instruction set is picked at compile time from the target flags (build with -mavx2 to get
+// the AVX path on x86, SSE2 is the x86-64 baseline and NEON the arm64 one).
+//
+// Rows are loaded with unaligned vector loads of consecutive channels inside one frame (two-float
+// loads for a pair), so the kernels never read past the end of a frame and therefore never past
+// the end of the ring.
+//
+// When a ChannelStats array is passed, each channel's peak and sum of squares are accumulated
+// from the transposed registers before they are stored, so metering costs no second sweep.
+//
+// The output gain is applied the same way: a GainRamp gives a start gain and a per-frame step,
+// and the transposed registers are multiplied by one ramp vector per group of frames, shared by
+// every channel group, before they are stored and measured. Unity gain is just the default ramp.
+//
+// Rings in a compact encoding (int16, int24, fp16; see SampleFormat.h) go through
+// readFromRingEncoded(), which decodes a cache-sized chunk of whole frames at a time into floats
+// and feeds the chunk to the same transpose kernels.
+
+#include "SampleFormat.h"
+
+#if defined (__AVX__)
+ #include <immintrin.h>
+ #define RING_DEINTERLEAVE_AVX 1
+ #define RING_DEINTERLEAVE_SSE 1
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define RING_DEINTERLEAVE_SSE 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define RING_DEINTERLEAVE_NEON 1
+#endif
+
+#if defined (_MSC_VER)
+ #define RING_DEINTERLEAVE_ALWAYS_INLINE __forceinline
+#else
+ #define RING_DEINTERLEAVE_ALWAYS_INLINE inline __attribute__ ((always_inline))
+#endif
+
+namespace RingDeinterleave
+{
+    // One contiguous run of ring frames and where it lands in the destination block.
+    struct Span
+    {
+        uint64_t ringFrame = 0; // Masked frame position in the ring
+        int destOffset = 0;     // Sample offset in the planar destination
+        int numFrames = 0;
+    };
+
+    // Per-channel level accumulators, filled while copying. Callers zero them before a block.
+    struct ChannelStats
+    {
+        float peak = 0.0f;
+        float sumSquares = 0.0f;
+    };
+
+    // Gain for destination sample j of a read: start + step * j. Sample offsets count from the
+    // start of the whole read, so the ramp runs on across the wraparound.
+    struct GainRamp
+    {
+        float start = 1.0f;
+        float step = 0.0f;
+
+        float at (int destSample) const noexcept   { return start + step * (float) destSample; }
+    };
+
+    // Upper bound on channels that can be measured in one read.
+    static constexpr int maxMeasuredChannels = 32;
+
+    // Splits a read of numFrames starting at readIndex into at most two spans at the ring wraparound.
+    // numFrames must not exceed the ring capacity (mask + 1). Returns the number of spans used.
+    inline int splitIntoSpans (uint64_t readIndex, int numFrames, uint64_t mask, Span (&spans)[2]) noexcept
+    {
+        const uint64_t start = readIndex & mask;
+        const uint64_t untilWrap = (mask + 1) - start;
+        const int firstLength = (int) std::min<uint64_t> ((uint64_t) numFrames, untilWrap);
+
+        spans[0] = { start, 0, firstLength };
+
+        if (firstLength == numFrames)
+            return 1;
+
+        spans[1] = { 0, firstLength, numFrames - firstLength };
+        return 2;
+    }
+
+    //==============================================================================
+    // Scalar copy of the rectangle [channelBegin, channelEnd) x [frameBegin, frameEnd).
+    // `src` points at the first wanted channel of the first frame of the span.
+    template <bool Measure>
+    inline void copyRectScalar (const float* src, int stride, float* const* dest, int destOffset,
+                                int channelBegin, int channelEnd, int frameBegin, int frameEnd,
+                                const GainRamp& gain, ChannelStats* stats) noexcept
+    {
+        for (int ch = channelBegin; ch < channelEnd; ++ch)
+        {
+            const float* s = src + ch;
+            float* d = dest[ch] + destOffset;
+            float peak = 0.0f, sumSquares = 0.0f;
+
+            for (int i = frameBegin; i < frameEnd; ++i)
+            {
+                const float sample = s[(size_t) i * (size_t) stride] * gain.at (destOffset + i);
+                d[i] = sample;
+
+                if constexpr (Measure)
+                {
+                    peak = std::max (peak, std::abs (sample));
+                    sumSquares += sample * sample;
+                }
+            }
+
+            if constexpr (Measure)
+            {
+                stats[ch].peak = std::max (stats[ch].peak, peak);
+                stats[ch].sumSquares += sumSquares;
+            }
+        }
+    }
+
+   #if RING_DEINTERLEAVE_SSE
+    struct SseAccumulators
+    {
+        __m128 sumSquares[maxMeasuredChannels];
+        __m128 peak[maxMeasuredChannels];
+
+        void reset (int numChannels) noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                sumSquares[ch] = peak[ch] = _mm_setzero_ps();
+        }
+
+        void add (int ch, __m128 v) noexcept
+        {
+            sumSquares[ch] = _mm_add_ps (sumSquares[ch], _mm_mul_ps (v, v));
+            peak[ch] = _mm_max_ps (peak[ch], _mm_andnot_ps (_mm_set1_ps (-0.0f), v));
+        }
+
+        void reduceInto (ChannelStats* stats, int numChannels) const noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                alignas (16) float s[4], p[4];
+                _mm_store_ps (s, sumSquares[ch]);
+                _mm_store_ps (p, peak[ch]);
+
+                stats[ch].sumSquares += (s[0] + s[1]) + (s[2] + s[3]);
+                stats[ch].peak = std::max ({ stats[ch].peak, p[0], p[1], p[2], p[3] });
+            }
+        }
+    };
+
+    // 4 frames x 4 channels at a time. Returns the end of the frames handled (frameBegin plus a
+    // multiple of 4); channels beyond the last full group of four are left for the scalar tail.
+    template <bool Measure>
+    inline int copyFrames4x4Sse (const float* src, int stride, float* const* dest, int destOffset,
+                                 int channelBegin, int channelEnd, int frameBegin, int numFrames,
+                                 const GainRamp& gain, SseAccumulators& acc) noexcept
+    {
+        const int vecEnd = frameBegin + ((numFrames - frameBegin) & ~3);
+        const __m128 steps = _mm_mul_ps (_mm_set1_ps (gain.step), _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f));
+
+        for (int i = frameBegin; i < vecEnd; i += 4)
+        {
+            const float* row = src + (size_t) i * (size_t) stride;
+            const __m128 g = _mm_add_ps (_mm_set1_ps (gain.at (destOffset + i)), steps);
+
+            for (int ch = channelBegin; ch + 4 <= channelEnd; ch += 4)
+            {
+                __m128 r0 = _mm_loadu_ps (row + ch);
+                __m128 r1 = _mm_loadu_ps (row + stride + ch);
+                __m128 r2 = _mm_loadu_ps (row + 2 * stride + ch);
+                __m128 r3 = _mm_loadu_ps (row + 3 * stride + ch);
+
+                _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+                r0 = _mm_mul_ps (r0, g);
+                r1 = _mm_mul_ps (r1, g);
+                r2 = _mm_mul_ps (r2, g);
+                r3 = _mm_mul_ps (r3, g);
+
+                _mm_storeu_ps (dest[ch]     + destOffset + i, r0);
+                _mm_storeu_ps (dest[ch + 1] + destOffset + i, r1);
+                _mm_storeu_ps (dest[ch + 2] + destOffset + i, r2);
+                _mm_storeu_ps (dest[ch + 3] + destOffset + i, r3);
+
+                if constexpr (Measure)
+                {
+                    acc.add (ch, r0);
+                    acc.add (ch + 1, r1);
+                    acc.add (ch + 2, r2);
+                    acc.add (ch + 3, r3);
+                }
+            }
+        }
+
+        return vecEnd;
+    }
+
+    // 4 frames x 2 channels at a time, for each pair in [channelBegin, channelEnd). Two frames' pairs
+    // go into one register and a shuffle splits the even and odd lanes into the two channels.
+    // Returns the end of the frames handled, as copyFrames4x4Sse does.
+    template <bool Measure>
+    inline int copyFrames4x2Sse (const float* src, int stride, float* const* dest, int destOffset,
+                                 int channelBegin, int channelEnd, int frameBegin, int numFrames,
+                                 const GainRamp& gain, SseAccumulators& acc) noexcept
+    {
+        const int vecEnd = frameBegin + ((numFrames - frameBegin) & ~3);
+        const __m128 steps = _mm_mul_ps (_mm_set1_ps (gain.step), _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f));
+
+        for (int i = frameBegin; i < vecEnd; i += 4)
+        {
+            const float* row = src + (size_t) i * (size_t) stride;
+            const __m128 g = _mm_add_ps (_mm_set1_ps (gain.at (destOffset + i)), steps);
+
+            for (int ch = channelBegin; ch + 2 <= channelEnd; ch += 2)
+            {
+                const __m128 frames01 = _mm_loadh_pi (_mm_castpd_ps (_mm_load_sd (reinterpret_cast<const double*> (row + ch))),
+                                                      reinterpret_cast<const __m64*> (row + stride + ch));
+                const __m128 frames23 = _mm_loadh_pi (_mm_castpd_ps (_mm_load_sd (reinterpret_cast<const double*> (row + 2 * stride + ch))),
+                                                      reinterpret_cast<const __m64*> (row + 3 * stride + ch));
+
+                const __m128 c0 = _mm_mul_ps (_mm_shuffle_ps (frames01, frames23, _MM_SHUFFLE (2, 0, 2, 0)), g);
+                const __m128 c1 = _mm_mul_ps (_mm_shuffle_ps (frames01, frames23, _MM_SHUFFLE (3, 1, 3, 1)), g);
+
+                _mm_storeu_ps (dest[ch]     + destOffset + i, c0);
+                _mm_storeu_ps (dest[ch + 1] + destOffset + i, c1);
+
+                if constexpr (Measure)
+                {
+                    acc.add (ch, c0);
+                    acc.add (ch + 1, c1);
+                }
+            }
+        }
+
+        return vecEnd;
+    }
+   #endif
+
+   #if RING_DEINTERLEAVE_AVX
+    struct AvxAccumulators
+    {
+        __m256 sumSquares[maxMeasuredChannels];
+        __m256 peak[maxMeasuredChannels];
+
+        void reset (int numChannels) noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                sumSquares[ch] = peak[ch] = _mm256_setzero_ps();
+        }
+
+        void add (int ch, __m256 v) noexcept
+        {
+            sumSquares[ch] = _mm256_add_ps (sumSquares[ch], _mm256_mul_ps (v, v));
+            peak[ch] = _mm256_max_ps (peak[ch], _mm256_andnot_ps (_mm256_set1_ps (-0.0f), v));
+        }
+
+        // Folds the 8-lane accumulators into the 4-lane ones so there is a single reduction.
+        void foldInto (SseAccumulators& sse, int numChannels) const noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                sse.sumSquares[ch] = _mm_add_ps (sse.sumSquares[ch], _mm_add_ps (_mm256_castps256_ps128 (sumSquares[ch]),
+                                                                                  _mm256_extractf128_ps (sumSquares[ch], 1)));
+                sse.peak[ch] = _mm_max_ps (sse.peak[ch], _mm_max_ps (_mm256_castps256_ps128 (peak[ch]),
+                                                                      _mm256_extractf128_ps (peak[ch], 1)));
+            }
+        }
+    };
+
+    // 8 frames x 8 channels at a time. Returns the number of frames handled (a multiple of 8).
+    template <bool Measure>
+    inline int copyFrames8x8Avx (const float* src, int stride, float* const* dest, int destOffset,
+                                 int channelEnd, int numFrames, const GainRamp& gain, AvxAccumulators& acc) noexcept
+    {
+        const int vecEnd = numFrames & ~7;
+        const __m256 steps = _mm256_mul_ps (_mm256_set1_ps (gain.step),
+                                            _mm256_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+
+        for (int i = 0; i < vecEnd; i += 8)
+        {
+            const float* row = src + (size_t) i * (size_t) stride;
+            const __m256 g = _mm256_add_ps (_mm256_set1_ps (gain.at (destOffset + i)), steps);
+
+            for (int ch = 0; ch + 8 <= channelEnd; ch += 8)
+            {
+                const __m256 r0 = _mm256_loadu_ps (row + ch);
+                const __m256 r1 = _mm256_loadu_ps (row + stride + ch);
+                const __m256 r2 = _mm256_loadu_ps (row + 2 * stride + ch);
+                const __m256 r3 = _mm256_loadu_ps (row + 3 * stride + ch);
+                const __m256 r4 = _mm256_loadu_ps (row + 4 * stride + ch);
+                const __m256 r5 = _mm256_loadu_ps (row + 5 * stride + ch);
+                const __m256 r6 = _mm256_loadu_ps (row + 6 * stride + ch);
+                const __m256 r7 = _mm256_loadu_ps (row + 7 * stride + ch);
+
+                const __m256 t0 = _mm256_unpacklo_ps (r0, r1);
+                const __m256 t1 = _mm256_unpackhi_ps (r0, r1);
+                const __m256 t2 = _mm256_unpacklo_ps (r2, r3);
+                const __m256 t3 = _mm256_unpackhi_ps (r2, r3);
+                const __m256 t4 = _mm256_unpacklo_ps (r4, r5);
+                const __m256 t5 = _mm256_unpackhi_ps (r4, r5);
+                const __m256 t6 = _mm256_unpacklo_ps (r6, r7);
+                const __m256 t7 = _mm256_unpackhi_ps (r6, r7);
+
+                const __m256 s0 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (1, 0, 1, 0));
+                const __m256 s1 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (3, 2, 3, 2));
+                const __m256 s2 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (1, 0, 1, 0));
+                const __m256 s3 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (3, 2, 3, 2));
+                const __m256 s4 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE (1, 0, 1, 0));
+                const __m256 s5 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE (3, 2, 3, 2));
+                const __m256 s6 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE (1, 0, 1, 0));
+                const __m256 s7 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE (3, 2, 3, 2));
+
+                const __m256 c[8] = { _mm256_mul_ps (_mm256_permute2f128_ps (s0, s4, 0x20), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s1, s5, 0x20), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s2, s6, 0x20), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s3, s7, 0x20), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s0, s4, 0x31), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s1, s5, 0x31), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s2, s6, 0x31), g),
+                                      _mm256_mul_ps (_mm256_permute2f128_ps (s3, s7, 0x31), g) };
+
+                for (int k = 0; k < 8; ++k)
+                {
+                    _mm256_storeu_ps (dest[ch + k] + destOffset + i, c[k]);
+
+                    if constexpr (Measure)
+                        acc.add (ch + k, c[k]);
+                }
+            }
+        }
+
+        return vecEnd;
+    }
+   #endif
+
+   #if RING_DEINTERLEAVE_NEON
+    struct NeonAccumulators
+    {
+        float32x4_t sumSquares[maxMeasuredChannels];
+        float32x4_t peak[maxMeasuredChannels];
+
+        void reset (int numChannels) noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                sumSquares[ch] = peak[ch] = vdupq_n_f32 (0.0f);
+        }
+
+        void add (int ch, float32x4_t v) noexcept
+        {
+            sumSquares[ch] = vmlaq_f32 (sumSquares[ch], v, v);
+            peak[ch] = vmaxq_f32 (peak[ch], vabsq_f32 (v));
+        }
+
+        void reduceInto (ChannelStats* stats, int numChannels) const noexcept
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                float s[4], p[4];
+                vst1q_f32 (s, sumSquares[ch]);
+                vst1q_f32 (p, peak[ch]);
+
+                stats[ch].sumSquares += (s[0] + s[1]) + (s[2] + s[3]);
+                stats[ch].peak = std::max ({ stats[ch].peak, p[0], p[1], p[2], p[3] });
+            }
+        }
+    };
+
+    template <bool Measure>
+    inline int copyFrames4x4Neon (const float* src, int stride, float* const* dest, int destOffset,
+                                  int channelEnd, int numFrames, const GainRamp& gain, NeonAccumulators& acc) noexcept
+    {
+        const int vecEnd = numFrames & ~3;
+        const float frameSteps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const float32x4_t steps = vmulq_n_f32 (vld1q_f32 (frameSteps), gain.step);
+
+        for (int i = 0; i < vecEnd; i += 4)
+        {
+            const float* row = src + (size_t) i * (size_t) stride;
+            const float32x4_t g = vaddq_f32 (vdupq_n_f32 (gain.at (destOffset + i)), steps);
+
+            for (int ch = 0; ch + 4 <= channelEnd; ch += 4)
+            {
+                const float32x4x2_t t01 = vtrnq_f32 (vld1q_f32 (row + ch),              vld1q_f32 (row + stride + ch));
+                const float32x4x2_t t23 = vtrnq_f32 (vld1q_f32 (row + 2 * stride + ch), vld1q_f32 (row + 3 * stride + ch));
+
+                const float32x4_t c[4] = { vmulq_f32 (vcombine_f32 (vget_low_f32  (t01.val[0]), vget_low_f32  (t23.val[0])), g),
+                                           vmulq_f32 (vcombine_f32 (vget_low_f32  (t01.val[1]), vget_low_f32  (t23.val[1])), g),
+                                           vmulq_f32 (vcombine_f32 (vget_high_f32 (t01.val[0]), vget_high_f32 (t23.val[0])), g),
+                                           vmulq_f32 (vcombine_f32 (vget_high_f32 (t01.val[1]), vget_high_f32 (t23.val[1])), g) };
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    vst1q_f32 (dest[ch + k] + destOffset + i, c[k]);
+
+                    if constexpr (Measure)
+                        acc.add (ch + k, c[k]);
+                }
+            }
+        }
+
+        return vecEnd;
+    }
+
+    // 4 frames x 2 channels at a time, for each pair in [channelBegin, channelEnd): vuzp splits two
+    // frames' pairs per register into the two channels.
+    template <bool Measure>
+    inline int copyFrames4x2Neon (const float* src, int stride, float* const* dest, int destOffset,
+                                  int channelBegin, int channelEnd, int numFrames, const GainRamp& gain,
+                                  NeonAccumulators& acc) noexcept
+    {
+        const int vecEnd = numFrames & ~3;
+        const float frameSteps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const float32x4_t steps = vmulq_n_f32 (vld1q_f32 (frameSteps), gain.step);
+
+        for (int i = 0; i < vecEnd; i += 4)
+        {
+            const float* row = src + (size_t) i * (size_t) stride;
+            const float32x4_t g = vaddq_f32 (vdupq_n_f32 (gain.at (destOffset + i)), steps);
+
+            for (int ch = channelBegin; ch + 2 <= channelEnd; ch += 2)
+            {
+                const float32x4x2_t pairs = vuzpq_f32 (vcombine_f32 (vld1_f32 (row + ch),              vld1_f32 (row + stride + ch)),
+                                                       vcombine_f32 (vld1_f32 (row + 2 * stride + ch), vld1_f32 (row + 3 * stride + ch)));
+
+                const float32x4_t c0 = vmulq_f32 (pairs.val[0], g);
+                const float32x4_t c1 = vmulq_f32 (pairs.val[1], g);
+
+                vst1q_f32 (dest[ch]     + destOffset + i, c0);
+                vst1q_f32 (dest[ch + 1] + destOffset + i, c1);
+
+                if constexpr (Measure)
+                {
+                    acc.add (ch, c0);
+                    acc.add (ch + 1, c1);
+                }
+            }
+        }
+
+        return vecEnd;
+    }
+   #endif
+
+    //==============================================================================
+    // Copies numFrames frames of one contiguous span. `src` points at the first wanted channel of
+    // the first frame; dest[0..numDest) receive consecutive channels from there.
+    template <bool Measure>
+    RING_DEINTERLEAVE_ALWAYS_INLINE void copySpan (const float* src, int stride, float* const* dest, int numDest,
+                          int destOffset, int numFrames, const GainRamp& gain, ChannelStats* stats) noexcept
+    {
+       #if RING_DEINTERLEAVE_AVX
+        const int channels8 = numDest & ~7;
+        const int channels4 = numDest & ~3;
+        const int channels2 = numDest & ~1;
+
+        AvxAccumulators wide;
+        SseAccumulators narrow;
+
+        if constexpr (Measure)
+        {
+            wide.reset (channels8);
+            narrow.reset (channels2);
+        }
+
+        const int frames8 = copyFrames8x8Avx<Measure> (src, stride, dest, destOffset, channels8, numFrames, gain, wide);
+
+        // Frames the 8x8 pass covered still need any channels past the last group of eight,
+        // and the frame tail needs all channels.
+        const int tailFrames4 = copyFrames4x4Sse<Measure> (src, stride, dest, destOffset, 0, channels4, frames8, numFrames, gain, narrow);
+        copyFrames4x4Sse<Measure> (src, stride, dest, destOffset, channels8, channels4, 0, frames8, gain, narrow);
+        copyFrames4x2Sse<Measure> (src, stride, dest, destOffset, channels4, channels2, 0, numFrames, gain, narrow);
+
+        copyRectScalar<Measure> (src, stride, dest, destOffset, channels2, numDest, 0, numFrames, gain, stats);
+        copyRectScalar<Measure> (src, stride, dest, destOffset, 0, channels2, tailFrames4, numFrames, gain, stats);
+
+        if constexpr (Measure)
+        {
+            wide.foldInto (narrow, channels8);
+            narrow.reduceInto (stats, channels2);
+        }
+       #elif RING_DEINTERLEAVE_SSE
+        const int channels4 = numDest & ~3;
+        const int channels2 = numDest & ~1;
+
+        SseAccumulators acc;
+
+        if constexpr (Measure)
+            acc.reset (channels2);
+
+        const int frames4 = copyFrames4x4Sse<Measure> (src, stride, dest, destOffset, 0, channels4, 0, numFrames, gain, acc);
+        copyFrames4x2Sse<Measure> (src, stride, dest, destOffset, channels4, channels2, 0, numFrames, gain, acc);
+
+        copyRectScalar<Measure> (src, stride, dest, destOffset, channels2, numDest, 0, numFrames, gain, stats);
+        copyRectScalar<Measure> (src, stride, dest, destOffset, 0, channels2, frames4, numFrames, gain, stats);
+
+        if constexpr (Measure)
+            acc.reduceInto (stats, channels2);
+       #elif RING_DEINTERLEAVE_NEON
+        const int channels4 = numDest & ~3;
+        const int channels2 = numDest & ~1;
+
+        NeonAccumulators acc;
+
+        if constexpr (Measure)
+            acc.reset (channels2);
+
+        const int frames4 = copyFrames4x4Neon<Measure> (src, stride, dest, destOffset, channels4, numFrames, gain, acc);
+        copyFrames4x2Neon<Measure> (src, stride, dest, destOffset, channels4, channels2, numFrames, gain, acc);
+
+        copyRectScalar<Measure> (src, stride, dest, destOffset, channels2, numDest, 0, numFrames, gain, stats);
+        copyRectScalar<Measure> (src, stride, dest, destOffset, 0, channels2, frames4, numFrames, gain, stats);
+
+        if constexpr (Measure)
+            acc.reduceInto (stats, channels2);
+       #else
+        copyRectScalar<Measure> (src, stride, dest, destOffset, 0, numDest, 0, numFrames, gain, stats);
+       #endif
+    }
+
+    // readFromRing with the frame stride and channel count fixed at compile time. Once copySpan is
+    // inlined into an instantiation, the channel-group loops and stride multiplications become
+    // constants. Used for the common layouts through readContiguous().
+    template <int Stride, int NumDest>
+    inline void readFromRingFixed (const float* ring, uint64_t mask, int firstChannel, uint64_t readIndex,
+                                   int numFrames, float* const* dest, ChannelStats* stats, const GainRamp& gain = {}) noexcept
+    {
+        static_assert (NumDest <= Stride && NumDest <= maxMeasuredChannels, "Channel layout doesn't fit the frame");
+
+        if (numFrames <= 0)
+            return;
+
+        Span spans[2];
+        const int numSpans = splitIntoSpans (readIndex, numFrames, mask, spans);
+
+        for (int s = 0; s < numSpans; ++s)
+        {
+            const float* src = ring + (size_t) spans[s].ringFrame * (size_t) Stride + (size_t) firstChannel;
+
+            if (stats != nullptr)
+                copySpan<true> (src, Stride, dest, NumDest, spans[s].destOffset, spans[s].numFrames, gain, stats);
+            else
+                copySpan<false> (src, Stride, dest, NumDest, spans[s].destOffset, spans[s].numFrames, gain, nullptr);
+        }
+    }
+
+    // Reads numFrames frames starting at readIndex out of an interleaved ring of `stride` channels,
+    // taking numDest consecutive channels starting at firstChannel into the planar dest pointers.
+    // numFrames must not exceed the ring capacity and firstChannel + numDest must not exceed stride.
+    // If stats is non-null it must hold numDest entries (at most maxMeasuredChannels), which are
+    // accumulated into rather than reset. Samples are scaled by `gain` on the way through, and
+    // measured after it.
+    inline void readFromRing (const float* ring, uint64_t mask, int stride, int firstChannel,
+                              uint64_t readIndex, int numFrames, float* const* dest, int numDest,
+                              ChannelStats* stats = nullptr, const GainRamp& gain = {}) noexcept
+    {
+        if (numFrames <= 0 || numDest <= 0)
+            return;
+
+        Span spans[2];
+        const int numSpans = splitIntoSpans (readIndex, numFrames, mask, spans);
+
+        for (int s = 0; s < numSpans; ++s)
+        {
+            const float* src = ring + (size_t) spans[s].ringFrame * (size_t) stride + (size_t) firstChannel;
+
+            if (stats != nullptr && numDest <= maxMeasuredChannels)
+                copySpan<true> (src, stride, dest, numDest, spans[s].destOffset, spans[s].numFrames, gain, stats);
+            else
+                copySpan<false> (src, stride, dest, numDest, spans[s].destOffset, spans[s].numFrames, gain, nullptr);
+        }
+    }
+
+    // Floats decoded per chunk by readFromRingEncoded: small enough to stay in L1 between the
+    // decode and the transpose.
+    static constexpr int decodeScratchSamples = 2048;
+
+    // readFromRing for a ring of `encoding` samples; `ring` is the start of the sample area. Each
+    // span is decoded in chunks of whole frames, so the decoders run over contiguous bytes (dummy
+    // channels included, they share the cache lines anyway), then transposed from the scratch.
+    // Same requirements as readFromRing, and stride must not exceed decodeScratchSamples / 8.
+    inline void readFromRingEncoded (const uint8_t* ring, SampleFormat::Encoding encoding, uint64_t mask, int stride,
+                                     int firstChannel, uint64_t readIndex, int numFrames, float* const* dest, int numDest,
+                                     ChannelStats* stats = nullptr, const GainRamp& gain = {}) noexcept
+    {
+        if (numFrames <= 0 || numDest <= 0 || stride > decodeScratchSamples / 8)
+            return;
+
+        alignas (64) float scratch[decodeScratchSamples];
+
+        const size_t frameBytes = (size_t) stride * (size_t) SampleFormat::bytesPerSample (encoding);
+        const int chunkFrames = (decodeScratchSamples / stride) & ~7;  // Whole vectors for the transposes
+        const bool measure = stats != nullptr && numDest <= maxMeasuredChannels;
+
+        Span spans[2];
+        const int numSpans = splitIntoSpans (readIndex, numFrames, mask, spans);
+
+        for (int s = 0; s < numSpans; ++s)
+        {
+            for (int done = 0; done < spans[s].numFrames; done += chunkFrames)
+            {
+                const int frames = std::min (chunkFrames, spans[s].numFrames - done);
+
+                SampleFormat::decode (encoding, ring + (size_t) (spans[s].ringFrame + (uint64_t) done) * frameBytes,
+                                      scratch, frames * stride);
+
+                if (measure)
+                    copySpan<true> (scratch + firstChannel, stride, dest, numDest, spans[s].destOffset + done, frames, gain, stats);
+                else
+                    copySpan<false> (scratch + firstChannel, stride, dest, numDest, spans[s].destOffset + done, frames, gain, nullptr);
+            }
+        }
+    }
+
+    // Picks a specialised readFromRingFixed instance for the sender's 10-channel frame and the
+    // usual output widths, and the generic readFromRing for anything else.
+    inline void readContiguous (const float* ring, uint64_t mask, int stride, int firstChannel,
+                                uint64_t readIndex, int numFrames, float* const* dest, int numDest,
+                                ChannelStats* stats = nullptr, const GainRamp& gain = {}) noexcept
+    {
+        if (stride == 10 && firstChannel + numDest <= 10)
+        {
+            switch (numDest)
+            {
+                case 2:  readFromRingFixed<10, 2>  (ring, mask, firstChannel, readIndex, numFrames, dest, stats, gain); return;
+                case 4:  readFromRingFixed<10, 4>  (ring, mask, firstChannel, readIndex, numFrames, dest, stats, gain); return;
+                case 8:  readFromRingFixed<10, 8>  (ring, mask, firstChannel, readIndex, numFrames, dest, stats, gain); return;
+                case 10: readFromRingFixed<10, 10> (ring, mask, firstChannel, readIndex, numFrames, dest, stats, gain); return;
+                default: break;
+            }
+        }
+
+        readFromRing (ring, mask, stride, firstChannel, readIndex, numFrames, dest, numDest, stats, gain);
+    }
+}
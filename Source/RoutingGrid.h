@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "RoutingMatrix.h"
+
+// Click grid for the routing matrix: one row per output channel, one column per shared channel.
+// A lit cell routes that shared channel to that output; several lit cells in a row are summed,
+// an empty row is muted. The sender's dummy channels are shown dimmed but can still be routed, and
+// so are the rows of output buses the host has disabled.
+class RoutingGrid : public juce::Component
+{
+public:
+    RoutingGrid(RoutingMatrix& matrixToEdit, int numSharedChannels, int numDummyChannels)
+        : matrix(matrixToEdit), numSources(numSharedChannels), numDummies(numDummyChannels)
+    {
+    }
+
+    void setNumOutputs(int newNumOutputs)
+    {
+        newNumOutputs = juce::jlimit(0, RoutingMatrix::maxOutputs, newNumOutputs);
+
+        if (newNumOutputs != numOutputs)
+        {
+            numOutputs = newNumOutputs;
+            repaint();
+        }
+    }
+
+    // Rows of enabled output buses, one bit each.
+    void setPlayedOutputs(uint32_t newPlayedOutputs)
+    {
+        if (newPlayedOutputs != playedOutputs)
+        {
+            playedOutputs = newPlayedOutputs;
+            repaint();
+        }
+    }
+
+    // The connected sender's frame width; self-describing senders may carry more or fewer channels.
+    void setNumSources(int newNumSources)
+    {
+        newNumSources = juce::jlimit(1, RoutingMatrix::maxSources, newNumSources);
+
+        if (newNumSources != numSources)
+        {
+            numSources = newNumSources;
+            repaint();
+        }
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        if (numOutputs == 0)
+            return;
+
+        g.setFont(juce::Font(10.0f));
+
+        for (int source = 0; source < numSources; ++source)
+        {
+            g.setColour(source < numDummies ? juce::Colours::darkgrey : juce::Colours::grey);
+            g.drawText(juce::String(source + 1), columnHeader(source), juce::Justification::centred, false);
+        }
+
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            const uint32_t mask = matrix.getSources(output);
+
+            const bool played = (playedOutputs & (uint32_t(1) << output)) != 0;
+
+            g.setColour(mask == 0 || !played ? juce::Colours::darkgrey : juce::Colours::grey);
+            g.drawText("Out " + juce::String(output + 1), rowHeader(output), juce::Justification::centredLeft, false);
+
+            for (int source = 0; source < numSources; ++source)
+            {
+                const auto cell = cellBounds(output, source).reduced(1.0f);
+                const bool connected = (mask & (uint32_t(1) << source)) != 0;
+
+                g.setColour(connected ? juce::Colours::goldenrod
+                                      : juce::Colour::fromRGB(40, 40, 40).brighter(source < numDummies ? 0.0f : 0.1f));
+                g.fillRect(cell);
+            }
+        }
+    }
+
+    void mouseDown(const juce::MouseEvent& event) override
+    {
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            for (int source = 0; source < numSources; ++source)
+            {
+                if (!cellBounds(output, source).contains(event.position))
+                    continue;
+
+                const bool connected = (matrix.getSources(output) & (uint32_t(1) << source)) != 0;
+                matrix.connect(output, source, !connected);
+                repaint();
+                return;
+            }
+        }
+    }
+
+private:
+    static constexpr float headerWidth = 40.0f;
+    static constexpr float headerHeight = 12.0f;
+
+    float cellWidth() const    { return ((float) getWidth() - headerWidth) / (float) juce::jmax(1, numSources); }
+    float cellHeight() const   { return juce::jmin(14.0f, ((float) getHeight() - headerHeight) / (float) juce::jmax(1, numOutputs)); }
+
+    juce::Rectangle<float> cellBounds(int output, int source) const
+    {
+        return { headerWidth + cellWidth() * (float) source, headerHeight + cellHeight() * (float) output, cellWidth(), cellHeight() };
+    }
+
+    juce::Rectangle<float> columnHeader(int source) const
+    {
+        return { headerWidth + cellWidth() * (float) source, 0.0f, cellWidth(), headerHeight };
+    }
+
+    juce::Rectangle<float> rowHeader(int output) const
+    {
+        return { 0.0f, headerHeight + cellHeight() * (float) output, headerWidth, cellHeight() };
+    }
+
+    RoutingMatrix& matrix;
+    int numSources;
+    const int numDummies;
+    int numOutputs = 0;
+    uint32_t playedOutputs = ~uint32_t(0);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RoutingGrid)
+};
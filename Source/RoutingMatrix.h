@@ -0,0 +1,311 @@
+#pragma once
+
+#include "RingDeinterleave.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Which shared-memory channels feed which output channel.
+//
+// Every output holds a bit mask of source channels (indices into the sender's interleaved frame,
+// dummies included): no bits is a muted output, one bit a plain copy, several bits a sum. The
+// message thread edits the masks; the audio thread turns them into a Plan whenever the version
+// moves, so a block never re-inspects the matrix.
+//
+// A plan that is just "output o <- source first + o" (the default, and any offset map) is marked
+// contiguous and read with RingDeinterleave's compile-time specialised kernels, so custom routing
+// only costs anything when it is actually used. Anything else goes through render(), which
+// de-interleaves the needed source range once and then copies or sums into the outputs.
+class RoutingMatrix
+{
+public:
+    static constexpr int maxOutputs = 32;
+    static constexpr int maxSources = 32;
+
+    RoutingMatrix()
+    {
+        for (auto& s : sources)
+            s.store (0, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    // Message thread.
+    void setSources (int output, uint32_t sourceMask) noexcept
+    {
+        if (output < 0 || output >= maxOutputs)
+            return;
+
+        sources[output].store (sourceMask, std::memory_order_relaxed);
+        version.fetch_add (1, std::memory_order_release);
+    }
+
+    uint32_t getSources (int output) const noexcept
+    {
+        return output >= 0 && output < maxOutputs ? sources[output].load (std::memory_order_relaxed) : 0;
+    }
+
+    void connect (int output, int source, bool shouldBeConnected) noexcept
+    {
+        if (source < 0 || source >= maxSources)
+            return;
+
+        const uint32_t bit = uint32_t (1) << source;
+        const uint32_t mask = getSources (output);
+        setSources (output, shouldBeConnected ? (mask | bit) : (mask & ~bit));
+    }
+
+    // output o <- source firstSource + o for o < numChannels; every other output muted.
+    void setOffsetMap (int firstSource, int numChannels) noexcept
+    {
+        for (int output = 0; output < maxOutputs; ++output)
+        {
+            const int source = firstSource + output;
+            const bool routed = output < numChannels && source >= 0 && source < maxSources;
+            sources[output].store (routed ? uint32_t (1) << source : 0, std::memory_order_relaxed);
+        }
+
+        version.fetch_add (1, std::memory_order_release);
+    }
+
+    // One entry per output up to the last routed one, comma separated: "-" for muted, otherwise
+    // source indices joined by '+', e.g. "2,3,2+3,-,6".
+    std::string toString() const
+    {
+        int numOutputs = maxOutputs;
+        while (numOutputs > 0 && getSources (numOutputs - 1) == 0)
+            --numOutputs;
+
+        std::string text;
+
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            if (output > 0)
+                text += ',';
+
+            const uint32_t mask = getSources (output);
+
+            if (mask == 0)
+            {
+                text += '-';
+                continue;
+            }
+
+            bool first = true;
+
+            for (int source = 0; source < maxSources; ++source)
+            {
+                if ((mask & (uint32_t (1) << source)) == 0)
+                    continue;
+
+                if (! first)
+                    text += '+';
+
+                text += std::to_string (source);
+                first = false;
+            }
+        }
+
+        return text;
+    }
+
+    // Parses toString()'s format. Leaves the matrix untouched and returns false on bad input.
+    bool fromString (const std::string& text)
+    {
+        uint32_t parsed[maxOutputs] {};
+        int output = 0, source = -1;
+
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            const char c = i < text.size() ? text[i] : ',';
+
+            if (c >= '0' && c <= '9')
+            {
+                source = (source < 0 ? 0 : source * 10) + (c - '0');
+
+                if (source >= maxSources)
+                    return false;
+            }
+            else if (c == '+' || c == ',')
+            {
+                if (source >= 0)
+                    parsed[output] |= uint32_t (1) << source;
+
+                source = -1;
+
+                if (c == ',' && ++output >= maxOutputs && i < text.size())
+                    return false;
+            }
+            else if (c != '-' && c != ' ')
+            {
+                return false;
+            }
+        }
+
+        for (int o = 0; o < maxOutputs; ++o)
+            sources[o].store (parsed[o], std::memory_order_relaxed);
+
+        version.fetch_add (1, std::memory_order_release);
+        return true;
+    }
+
+    //==============================================================================
+    // Which matrix row each channel of the host's buffer plays. Hosts leave disabled buses out of
+    // the buffer, so the channels after one move down; mapping them back to their rows keeps every
+    // bus on its own sources. The default is one row per channel, as when every bus is enabled.
+    struct OutputLayout
+    {
+        int numChannels = maxOutputs;   // Buffer channels that belong to an enabled bus
+        int numRows = maxOutputs;       // Rows for all buses, enabled or not
+        uint32_t id = 0;                // Changes whenever the layout does
+        uint8_t rows[maxOutputs];
+
+        OutputLayout() noexcept
+        {
+            for (int channel = 0; channel < maxOutputs; ++channel)
+                rows[channel] = (uint8_t) channel;
+        }
+
+        // The rows some buffer channel plays.
+        uint32_t getPlayedRows() const noexcept
+        {
+            uint32_t mask = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                mask |= uint32_t (1) << rows[channel];
+
+            return mask;
+        }
+    };
+
+    //==============================================================================
+    // Audio thread. Indexed by buffer channel (see OutputLayout), not by matrix row.
+    struct Plan
+    {
+        uint32_t version = ~uint32_t (0);
+        uint32_t layoutId = ~uint32_t (0);
+        int numSourceChannels = -1;
+        int numOutputs = 0;          // Outputs up to the last routed one; the rest are silent
+        bool contiguous = false;     // output o <- firstSource + o for every o < numOutputs
+        int firstSource = 0;
+        int lowestSource = 0, highestSource = -1;
+        uint32_t sources[maxOutputs] {};
+    };
+
+    // Refreshes `plan` if the matrix or the layout changed since it was built. Sources at or above
+    // numSourceChannels (what the sender's frame actually carries) are ignored.
+    void updatePlan (Plan& plan, int numSourceChannels, const OutputLayout& layout) const noexcept
+    {
+        const uint32_t current = version.load (std::memory_order_acquire);
+
+        if (current == plan.version && layout.id == plan.layoutId && numSourceChannels == plan.numSourceChannels)
+            return;
+
+        plan.version = current;
+        plan.layoutId = layout.id;
+        plan.numSourceChannels = numSourceChannels;
+
+        const uint32_t available = numSourceChannels >= 32 ? ~uint32_t (0) : (uint32_t (1) << numSourceChannels) - 1;
+        uint32_t all = 0;
+
+        plan.numOutputs = 0;
+
+        for (int output = 0; output < maxOutputs; ++output)
+        {
+            plan.sources[output] = output < layout.numChannels
+                                       ? sources[layout.rows[output]].load (std::memory_order_relaxed) & available : 0;
+            all |= plan.sources[output];
+
+            if (plan.sources[output] != 0)
+                plan.numOutputs = output + 1;
+        }
+
+        plan.lowestSource = 0;
+        plan.highestSource = -1;
+
+        for (int source = 0; source < maxSources; ++source)
+        {
+            if ((all & (uint32_t (1) << source)) == 0)
+                continue;
+
+            if (plan.highestSource < 0)
+                plan.lowestSource = source;
+
+            plan.highestSource = source;
+        }
+
+        plan.contiguous = plan.numOutputs > 0;
+        plan.firstSource = plan.contiguous ? lowestBit (plan.sources[0]) : 0;
+
+        for (int output = 0; output < plan.numOutputs && plan.contiguous; ++output)
+            plan.contiguous = plan.firstSource + output < maxSources
+                              && plan.sources[output] == uint32_t (1) << (plan.firstSource + output);
+    }
+
+    // Mixes de-interleaved source channels into the outputs following a non-contiguous plan.
+    // sourcePlanar[i] holds source plan.lowestSource + i. The gain ramp is applied as each source
+    // is copied or summed in, counted from destOffset like RingDeinterleave's reads, and the
+    // per-output stats, if given, are accumulated after it.
+    static void render (const Plan& plan, const float* const* sourcePlanar, float* const* dest, int numOutputs,
+                        int destOffset, int numFrames, RingDeinterleave::ChannelStats* stats,
+                        const RingDeinterleave::GainRamp& gain = {}) noexcept
+    {
+        const float startGain = gain.at (destOffset);
+
+        for (int output = 0; output < numOutputs; ++output)
+        {
+            float* d = dest[output] + destOffset;
+            uint32_t mask = plan.sources[output];
+
+            if (mask == 0)
+            {
+                std::memset (d, 0, sizeof (float) * (size_t) numFrames);
+                continue;
+            }
+
+            const float* first = sourcePlanar[lowestBit (mask) - plan.lowestSource];
+
+            for (int i = 0; i < numFrames; ++i)
+                d[i] = first[i] * (startGain + gain.step * (float) i);
+
+            mask &= mask - 1;
+
+            while (mask != 0)
+            {
+                const float* s = sourcePlanar[lowestBit (mask) - plan.lowestSource];
+
+                for (int i = 0; i < numFrames; ++i)
+                    d[i] += s[i] * (startGain + gain.step * (float) i);
+
+                mask &= mask - 1;
+            }
+
+            if (stats != nullptr)
+            {
+                float peak = stats[output].peak, sumSquares = 0.0f;
+
+                for (int i = 0; i < numFrames; ++i)
+                {
+                    peak = std::max (peak, std::abs (d[i]));
+                    sumSquares += d[i] * d[i];
+                }
+
+                stats[output].peak = peak;
+                stats[output].sumSquares += sumSquares;
+            }
+        }
+    }
+
+private:
+    static int lowestBit (uint32_t mask) noexcept
+    {
+        int bit = 0;
+        while (bit < 31 && (mask & (uint32_t (1) << bit)) == 0)
+            ++bit;
+        return bit;
+    }
+
+    std::atomic<uint32_t> sources[maxOutputs];
+    std::atomic<uint32_t> version { 0 };
+};
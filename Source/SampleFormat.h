@@ -0,0 +1,581 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Sample encodings the sender may use for the frames in the shared ring.
+//
+// The ring was sized for 32-bit floats, and float32 stays the default. A sender may pack frames
+// more tightly instead: frame f of a ring of `stride` channels starts at byte
+// (f & BUFFER_MASK) * stride * bytesPerSample (encoding) of audioData, so the ring keeps its frame
+// capacity and just touches fewer cache lines per frame. Samples are little-endian:
+//   - int16:   signed, full scale 32768
+//   - int24:   signed, packed into 3 bytes, full scale 8388608
+//   - float16: IEEE 754 binary16
+// Which encoding is in use, and from which frame on, is negotiated through the reader table (see
+// ReaderRegistry.h): every reader advertises the encodings it can decode, the sender only picks one
+// that all live readers support.
+//
+// decode() turns a run of contiguous samples into floats with SSE2/SSSE3/AVX2/F16C or NEON where
+// the target has them, and a scalar loop otherwise. x86 builds only assume SSE2, so the SSSE3, AVX2
+// and F16C decoders are also compiled with per-function target attributes and picked at run time
+// from CPUID when the build flags leave them out. encode() is scalar; it is for senders and tools.
+// Standard library only, so the sender can share it.
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <immintrin.h>
+ #define SAMPLE_FORMAT_SSE2 1
+ #if defined (__SSSE3__)
+  #define SAMPLE_FORMAT_SSSE3 1
+ #endif
+ #if defined (__AVX2__)
+  #define SAMPLE_FORMAT_AVX2 1
+ #endif
+ #if defined (__F16C__)
+  #define SAMPLE_FORMAT_F16C 1
+ #endif
+ #if ! (SAMPLE_FORMAT_SSSE3 && SAMPLE_FORMAT_AVX2 && SAMPLE_FORMAT_F16C) && (defined (__GNUC__) || defined (_MSC_VER))
+  #define SAMPLE_FORMAT_RUNTIME_DISPATCH 1
+  #if defined (_MSC_VER)
+   #include <intrin.h>
+  #else
+   #include <cpuid.h>
+  #endif
+ #endif
+ #if defined (__GNUC__)
+  #define SAMPLE_FORMAT_TARGET(isa) __attribute__ ((target (isa)))
+ #else
+  #define SAMPLE_FORMAT_TARGET(isa)   // MSVC emits any intrinsic without a flag
+ #endif
+#elif defined (__aarch64__) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define SAMPLE_FORMAT_NEON 1
+#endif
+
+namespace SampleFormat
+{
+    enum Encoding : uint32_t
+    {
+        float32 = 0,
+        int16   = 1,
+        int24   = 2,
+        float16 = 3,
+
+        numEncodings
+    };
+
+    // Bit mask of encodings, one bit per Encoding value. float32 is always understood.
+    inline constexpr uint32_t maskOf (Encoding e) noexcept         { return uint32_t (1) << e; }
+    static constexpr uint32_t allEncodings = (uint32_t (1) << numEncodings) - 1;
+
+    inline constexpr int bytesPerSample (Encoding e) noexcept
+    {
+        return e == int16 || e == float16 ? 2 : (e == int24 ? 3 : 4);
+    }
+
+    inline const char* getName (Encoding e) noexcept
+    {
+        switch (e)
+        {
+            case int16:     return "int16";
+            case int24:     return "int24";
+            case float16:   return "fp16";
+            case float32:
+            case numEncodings:
+            default:        break;
+        }
+
+        return "float";
+    }
+
+    // Accepts getName()'s spellings. Returns false for anything else.
+    inline bool fromName (const std::string& name, Encoding& result) noexcept
+    {
+        for (uint32_t e = 0; e < numEncodings; ++e)
+        {
+            if (name == getName ((Encoding) e))
+            {
+                result = (Encoding) e;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //==============================================================================
+    // Scalar conversions.
+    inline float halfToFloat (uint16_t h) noexcept
+    {
+        // Rebias the exponent in the integer domain; subnormal halves become normal floats with a
+        // subtraction, so nothing here depends on the FPU's denormal mode.
+        uint32_t bits = (uint32_t) (h & 0x7fff) << 13;
+        const uint32_t exponent = bits & (0x7c00u << 13);
+
+        bits += (127 - 15) << 23;
+
+        if (exponent == (0x7c00u << 13))
+            bits += (128 - 16) << 23;      // Inf/NaN
+
+        float f;
+
+        if (exponent == 0)
+        {
+            bits += 1 << 23;
+            std::memcpy (&f, &bits, sizeof (f));
+            f -= 6.103515625e-05f;         // 2^-14
+        }
+        else
+        {
+            std::memcpy (&f, &bits, sizeof (f));
+        }
+
+        uint32_t result;
+        std::memcpy (&result, &f, sizeof (result));
+        result |= (uint32_t) (h & 0x8000) << 16;
+        std::memcpy (&f, &result, sizeof (f));
+        return f;
+    }
+
+    // Round to nearest even; out-of-range values become infinity.
+    inline uint16_t floatToHalf (float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+
+        const uint32_t sign = (bits >> 16) & 0x8000;
+        bits &= 0x7fffffff;
+
+        if (bits >= 0x7f800000)                                        // Inf/NaN
+            return (uint16_t) (sign | 0x7c00 | (bits > 0x7f800000 ? 0x200 : 0));
+
+        if (bits >= 0x477ff000)                                        // Rounds past 65504
+            return (uint16_t) (sign | 0x7c00);
+
+        if (bits < 0x38800000)                                         // Subnormal half or zero
+        {
+            // Adding 0.5 lines the half's ulp (2^-24) up with the float's last mantissa bit, so
+            // the FPU does the rounding.
+            float magnitude;
+            std::memcpy (&magnitude, &bits, sizeof (magnitude));
+            magnitude += 0.5f;
+            std::memcpy (&bits, &magnitude, sizeof (bits));
+            return (uint16_t) (sign | (bits - 0x3f000000));
+        }
+
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += ((uint32_t) (15 - 127) << 23) + 0xfff + mantissaOdd;
+        return (uint16_t) (sign | (bits >> 13));
+    }
+
+    inline int32_t clampedRound (float value, float scale, int32_t lowest, int32_t highest) noexcept
+    {
+        const float scaled = value * scale;
+
+        if (! (scaled > (float) lowest))    return lowest;             // NaN lands here too
+        if (scaled >= (float) highest)      return highest;
+
+        return (int32_t) (scaled + (scaled < 0.0f ? -0.5f : 0.5f));
+    }
+
+    inline void encodeSample (Encoding e, float value, uint8_t* dest) noexcept
+    {
+        switch (e)
+        {
+            case int16:
+            {
+                const auto s = (int16_t) clampedRound (value, 32768.0f, -32768, 32767);
+                std::memcpy (dest, &s, 2);
+                return;
+            }
+
+            case int24:
+            {
+                const auto s = (uint32_t) clampedRound (value, 8388608.0f, -8388608, 8388607);
+                dest[0] = (uint8_t) s;
+                dest[1] = (uint8_t) (s >> 8);
+                dest[2] = (uint8_t) (s >> 16);
+                return;
+            }
+
+            case float16:
+            {
+                const uint16_t h = floatToHalf (value);
+                std::memcpy (dest, &h, 2);
+                return;
+            }
+
+            case float32:
+            case numEncodings:
+            default:
+                std::memcpy (dest, &value, 4);
+                return;
+        }
+    }
+
+    // Encodes numSamples contiguous floats.
+    inline void encode (Encoding e, const float* src, uint8_t* dest, int numSamples) noexcept
+    {
+        const int bytes = bytesPerSample (e);
+
+        for (int i = 0; i < numSamples; ++i)
+            encodeSample (e, src[i], dest + (size_t) i * (size_t) bytes);
+    }
+
+   #if SAMPLE_FORMAT_RUNTIME_DISPATCH
+    //==============================================================================
+    // What the CPU we're running on can do beyond the build's baseline. Detected once; AVX2 and
+    // F16C also need the OS to save the YMM registers.
+    struct CpuFeatures
+    {
+        bool ssse3 = false;
+        bool avx2 = false;
+        bool f16c = false;
+    };
+
+    inline CpuFeatures detectCpuFeatures() noexcept
+    {
+        uint32_t leaf1[4] = {}, leaf7[4] = {};
+
+       #if defined (_MSC_VER)
+        int regs[4];
+        __cpuid (regs, 0);
+        const int maxLeaf = regs[0];
+
+        __cpuid (regs, 1);
+        std::memcpy (leaf1, regs, sizeof (leaf1));
+
+        if (maxLeaf >= 7)
+        {
+            __cpuidex (regs, 7, 0);
+            std::memcpy (leaf7, regs, sizeof (leaf7));
+        }
+       #else
+        const unsigned int maxLeaf = __get_cpuid_max (0, nullptr);
+
+        __get_cpuid (1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+
+        if (maxLeaf >= 7)
+            __get_cpuid_count (7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+       #endif
+
+        const uint32_t ecx1 = leaf1[2];
+        bool ymmState = false;
+
+        if ((ecx1 & (1u << 27)) != 0 && (ecx1 & (1u << 28)) != 0)     // OSXSAVE and AVX
+        {
+           #if defined (_MSC_VER)
+            const uint64_t xcr0 = _xgetbv (0);
+           #else
+            uint32_t xcr0Low, xcr0High;
+            __asm__ ("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+            const uint64_t xcr0 = xcr0Low;
+           #endif
+            ymmState = (xcr0 & 6) == 6;
+        }
+
+        CpuFeatures features;
+        features.ssse3 = (ecx1 & (1u << 9)) != 0;
+        features.avx2  = ymmState && (leaf7[1] & (1u << 5)) != 0;
+        features.f16c  = ymmState && (ecx1 & (1u << 29)) != 0;
+        return features;
+    }
+
+    inline const CpuFeatures& cpuFeatures() noexcept
+    {
+        static const CpuFeatures features = detectCpuFeatures();
+        return features;
+    }
+   #endif
+
+    //==============================================================================
+    // Vector decoders: each handles as many whole vectors as fit in numSamples without reading past
+    // the last sample's bytes, and returns how many samples it did. The caller finishes the tail.
+   #if SAMPLE_FORMAT_AVX2 || SAMPLE_FORMAT_RUNTIME_DISPATCH
+    SAMPLE_FORMAT_TARGET ("avx2")
+    inline int decodeInt16Avx2 (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        const __m256 scale = _mm256_set1_ps (1.0f / 32768.0f);
+        int i = 0;
+
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            const __m256i packed = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (src + 2 * i));
+            _mm256_storeu_ps (dest + i,     _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (_mm256_castsi256_si128 (packed))), scale));
+            _mm256_storeu_ps (dest + i + 8, _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (_mm256_extracti128_si256 (packed, 1))), scale));
+        }
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i packed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i));
+            _mm256_storeu_ps (dest + i, _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (packed)), scale));
+        }
+
+        return i;
+    }
+
+    // Eight samples (24 bytes) per iteration: each 128-bit lane gets a 16-byte load holding four
+    // whole samples, spread into the top three bytes of its 32-bit lanes as in the SSSE3 decoder.
+    SAMPLE_FORMAT_TARGET ("avx2")
+    inline int decodeInt24Avx2 (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        const __m256i spread = _mm256_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                                 -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m256 scale = _mm256_set1_ps (1.0f / 8388608.0f);
+        int i = 0;
+
+        for (; i + 10 <= numSamples; i += 8)   // i + 10: the second 16-byte load stays inside the run
+        {
+            const __m256i packed = _mm256_inserti128_si256 (
+                _mm256_castsi128_si256 (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 3 * i))),
+                _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 3 * i + 12)), 1);
+
+            const __m256i lanes = _mm256_srai_epi32 (_mm256_shuffle_epi8 (packed, spread), 8);
+            _mm256_storeu_ps (dest + i, _mm256_mul_ps (_mm256_cvtepi32_ps (lanes), scale));
+        }
+
+        return i;
+    }
+   #endif
+
+   #if SAMPLE_FORMAT_SSSE3 || SAMPLE_FORMAT_RUNTIME_DISPATCH
+    // Each 16-byte load holds four whole samples (12 bytes). Spread each into the top three bytes
+    // of a 32-bit lane and shift right arithmetically to sign-extend.
+    SAMPLE_FORMAT_TARGET ("ssse3")
+    inline int decodeInt24Ssse3 (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        const __m128i spread = _mm_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m128 scale = _mm_set1_ps (1.0f / 8388608.0f);
+        int i = 0;
+
+        for (; i + 6 <= numSamples; i += 4)   // i + 6: the 16-byte load stays inside the run
+        {
+            const __m128i packed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 3 * i));
+            const __m128i lanes = _mm_srai_epi32 (_mm_shuffle_epi8 (packed, spread), 8);
+            _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_cvtepi32_ps (lanes), scale));
+        }
+
+        return i;
+    }
+   #endif
+
+   #if SAMPLE_FORMAT_F16C || SAMPLE_FORMAT_RUNTIME_DISPATCH
+    SAMPLE_FORMAT_TARGET ("avx,f16c")
+    inline int decodeHalfF16c (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            _mm256_storeu_ps (dest + i,     _mm256_cvtph_ps (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i))));
+            _mm256_storeu_ps (dest + i + 8, _mm256_cvtph_ps (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i + 16))));
+        }
+
+        for (; i + 8 <= numSamples; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_cvtph_ps (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i))));
+
+        return i;
+    }
+   #endif
+
+    inline int decodeInt16Vector (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+       #if SAMPLE_FORMAT_AVX2
+        i = decodeInt16Avx2 (src, dest, numSamples);
+       #elif SAMPLE_FORMAT_SSE2
+        #if SAMPLE_FORMAT_RUNTIME_DISPATCH
+        if (cpuFeatures().avx2)
+            return decodeInt16Avx2 (src, dest, numSamples);
+        #endif
+
+        const __m128 scale = _mm_set1_ps (1.0f / 32768.0f);
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i packed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i));
+
+            // Put each 16-bit sample in the top half of a 32-bit lane, then shift it back down with
+            // sign extension.
+            const __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (packed, packed), 16);
+            const __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (packed, packed), 16);
+
+            _mm_storeu_ps (dest + i,     _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+            _mm_storeu_ps (dest + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+        }
+       #elif SAMPLE_FORMAT_NEON
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const int16x8_t packed = vreinterpretq_s16_u8 (vld1q_u8 (src + 2 * i));
+
+            // Fixed-point conversion with 15 fractional bits is exactly the 1/32768 scale.
+            vst1q_f32 (dest + i,     vcvtq_n_f32_s32 (vmovl_s16 (vget_low_s16 (packed)), 15));
+            vst1q_f32 (dest + i + 4, vcvtq_n_f32_s32 (vmovl_s16 (vget_high_s16 (packed)), 15));
+        }
+       #else
+        (void) src; (void) dest; (void) numSamples;
+       #endif
+
+        return i;
+    }
+
+    inline int decodeInt24Vector (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+       #if SAMPLE_FORMAT_AVX2
+        i = decodeInt24Avx2 (src, dest, numSamples);
+       #elif SAMPLE_FORMAT_SSSE3 && ! SAMPLE_FORMAT_RUNTIME_DISPATCH
+        i = decodeInt24Ssse3 (src, dest, numSamples);
+       #elif SAMPLE_FORMAT_SSE2
+        #if SAMPLE_FORMAT_RUNTIME_DISPATCH
+        if (cpuFeatures().avx2)
+            i = decodeInt24Avx2 (src, dest, numSamples);
+
+        if (cpuFeatures().ssse3)
+            return i + decodeInt24Ssse3 (src + 3 * i, dest + i, numSamples - i);
+        #endif
+
+        // Without a byte shuffle: shift copies of the load so each sample starts a 32-bit lane,
+        // gather the low lanes, then drop the stray fourth byte with a shift pair.
+        const __m128 scale = _mm_set1_ps (1.0f / 8388608.0f);
+
+        for (; i + 6 <= numSamples; i += 4)
+        {
+            const __m128i packed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 3 * i));
+            const __m128i s01 = _mm_unpacklo_epi32 (packed, _mm_srli_si128 (packed, 3));
+            const __m128i s23 = _mm_unpacklo_epi32 (_mm_srli_si128 (packed, 6), _mm_srli_si128 (packed, 9));
+            const __m128i lanes = _mm_srai_epi32 (_mm_slli_epi32 (_mm_unpacklo_epi64 (s01, s23), 8), 8);
+            _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_cvtepi32_ps (lanes), scale));
+        }
+       #elif SAMPLE_FORMAT_NEON
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            // De-interleaving load: byte 0, 1 and 2 of eight samples in three registers.
+            const uint8x8x3_t bytes = vld3_u8 (src + 3 * i);
+
+            const uint16x8_t low  = vorrq_u16 (vmovl_u8 (bytes.val[0]), vshlq_n_u16 (vmovl_u8 (bytes.val[1]), 8));
+            const int16x8_t high  = vreinterpretq_s16_u16 (vshlq_n_u16 (vmovl_u8 (bytes.val[2]), 8));
+
+            // (high << 8) | low, with the sign coming from the top byte.
+            const int32x4_t s0 = vorrq_s32 (vshlq_n_s32 (vmovl_s16 (vget_low_s16 (high)), 8),
+                                            vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (low))));
+            const int32x4_t s1 = vorrq_s32 (vshlq_n_s32 (vmovl_s16 (vget_high_s16 (high)), 8),
+                                            vreinterpretq_s32_u32 (vmovl_u16 (vget_high_u16 (low))));
+
+            vst1q_f32 (dest + i,     vcvtq_n_f32_s32 (s0, 23));
+            vst1q_f32 (dest + i + 4, vcvtq_n_f32_s32 (s1, 23));
+        }
+       #else
+        (void) src; (void) dest; (void) numSamples;
+       #endif
+
+        return i;
+    }
+
+    inline int decodeHalfVector (const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+       #if SAMPLE_FORMAT_F16C
+        i = decodeHalfF16c (src, dest, numSamples);
+       #elif SAMPLE_FORMAT_SSE2
+        #if SAMPLE_FORMAT_RUNTIME_DISPATCH
+        if (cpuFeatures().f16c)
+            return decodeHalfF16c (src, dest, numSamples);
+        #endif
+
+        // halfToFloat() four lanes at a time.
+        const __m128i magnitudeMask = _mm_set1_epi32 (0x7fff);
+        const __m128i exponentMask  = _mm_set1_epi32 (0x7c00 << 13);
+        const __m128i rebias        = _mm_set1_epi32 ((127 - 15) << 23);
+        const __m128i infRebias     = _mm_set1_epi32 ((128 - 16) << 23);
+        const __m128i subnormalBit  = _mm_set1_epi32 (1 << 23);
+        const __m128 subnormalBase  = _mm_set1_ps (6.103515625e-05f);
+        const __m128i zero          = _mm_setzero_si128();
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m128i packed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (src + 2 * i));
+            const __m128i halves[2] = { _mm_unpacklo_epi16 (packed, zero), _mm_unpackhi_epi16 (packed, zero) };
+
+            for (int k = 0; k < 2; ++k)
+            {
+                const __m128i h = halves[k];
+                __m128i bits = _mm_slli_epi32 (_mm_and_si128 (h, magnitudeMask), 13);
+                const __m128i exponent = _mm_and_si128 (bits, exponentMask);
+
+                const __m128i isInfNan = _mm_cmpeq_epi32 (exponent, exponentMask);
+                const __m128i isSubnormal = _mm_cmpeq_epi32 (exponent, zero);
+
+                bits = _mm_add_epi32 (bits, rebias);
+                bits = _mm_add_epi32 (bits, _mm_and_si128 (isInfNan, infRebias));
+                bits = _mm_add_epi32 (bits, _mm_and_si128 (isSubnormal, subnormalBit));
+
+                __m128 f = _mm_castsi128_ps (bits);
+                f = _mm_sub_ps (f, _mm_and_ps (_mm_castsi128_ps (isSubnormal), subnormalBase));
+
+                const __m128i sign = _mm_slli_epi32 (_mm_andnot_si128 (magnitudeMask, h), 16);
+                _mm_storeu_ps (dest + i + 4 * k, _mm_or_ps (f, _mm_castsi128_ps (sign)));
+            }
+        }
+       #elif SAMPLE_FORMAT_NEON
+        for (; i + 4 <= numSamples; i += 4)
+            vst1q_f32 (dest + i, vcvt_f32_f16 (vreinterpret_f16_u8 (vld1_u8 (src + 2 * i))));
+       #else
+        (void) src; (void) dest; (void) numSamples;
+       #endif
+
+        return i;
+    }
+
+    // Decodes numSamples contiguous samples of encoding e into floats.
+    inline void decode (Encoding e, const uint8_t* src, float* dest, int numSamples) noexcept
+    {
+        int i = 0;
+
+        switch (e)
+        {
+            case int16:
+                i = decodeInt16Vector (src, dest, numSamples);
+
+                for (; i < numSamples; ++i)
+                {
+                    int16_t s;
+                    std::memcpy (&s, src + 2 * (size_t) i, 2);
+                    dest[i] = (float) s * (1.0f / 32768.0f);
+                }
+                return;
+
+            case int24:
+                i = decodeInt24Vector (src, dest, numSamples);
+
+                for (; i < numSamples; ++i)
+                {
+                    const uint8_t* s = src + 3 * (size_t) i;
+                    const auto value = (int32_t) ((uint32_t) s[0] << 8 | (uint32_t) s[1] << 16 | (uint32_t) s[2] << 24) >> 8;
+                    dest[i] = (float) value * (1.0f / 8388608.0f);
+                }
+                return;
+
+            case float16:
+                i = decodeHalfVector (src, dest, numSamples);
+
+                for (; i < numSamples; ++i)
+                {
+                    uint16_t h;
+                    std::memcpy (&h, src + 2 * (size_t) i, 2);
+                    dest[i] = halfToFloat (h);
+                }
+                return;
+
+            case float32:
+            case numEncodings:
+            default:
+                std::memcpy (dest, src, sizeof (float) * (size_t) numSamples);
+                return;
+        }
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "SampleFormat.h"
+
+// Self-describing layout for a sender's audio segment.
+//
+// SharedAudioData (SharedMemoryManager.h) fixes the channel count, ring size and sample type at
+// compile time, so sender and receiver have to be built against the same header. A segment that
+// starts with this header says all of that itself, and the receiver maps exactly segmentBytes:
+//
+//     [ Header | live fields | sample area: ringFrames frames of numChannels samples ]
+//
+// The first word is the magic. In a legacy segment the same offset holds writeIndex, a frame count
+// that never comes anywhere near it, so a receiver tells the two apart by reading one word.
+// A sender fills in the descriptor fields of a zeroed segment, stores the magic with release
+// semantics, and only then sets isActive. A segment whose size is within a page above
+// sizeof (SharedAudioData) is taken for a legacy one unless the magic is there, so a sender pads
+// its segment out of that range rather than have it misread before the magic is written.
+//
+// The live fields play the same roles as their SharedAudioData namesakes. ringFormat carries the
+// sample encoding packed as in the reader table (encoding << 56 | first frame, see
+// ReaderRegistry.h); for these segments it is authoritative and the table's copy is unused.
+// Where they sit depends on layoutVersion (SegmentV1, SegmentV2); locate() finds them.
+//
+// Version 2 segments also carry a time anchor: a frame, the clock reading the sender's timeline
+// gives that frame, and the sender host's musical position there, so a receiver can tell when a
+// frame was produced rather than only where it sits in the ring (see publishAnchor, readAnchor).
+//
+// Standard library only, so the sender can share it.
+namespace SegmentLayout
+{
+    static constexpr uint64_t magic = 0x3152444845535241ull;    // "ARSEHDR1" in memory order
+    static constexpr uint32_t version = 2;          // What describe() writes unless asked otherwise
+    static constexpr uint32_t oldestVersion = 1;    // Still read
+
+    static constexpr uint32_t maxChannels = 32;
+    static constexpr uint64_t minRingFrames = 256;
+    static constexpr uint64_t maxRingFrames = uint64_t (1) << 24;
+
+    // The descriptor, the same in every version. Written once before the magic.
+    struct Header
+    {
+        std::atomic<uint64_t> segmentMagic { 0 };
+        uint32_t layoutVersion = 0;
+        uint32_t headerBytes = 0;        // Where the sample area starts; a multiple of 64
+        uint32_t numChannels = 0;        // Samples per frame, dummies included
+        uint32_t reserved = 0;
+        uint64_t ringFrames = 0;         // Power of two
+        uint64_t sampleAreaBytes = 0;    // At least ringFrames * numChannels * the widest encoding used
+        uint64_t segmentBytes = 0;       // headerBytes + sampleAreaBytes
+        double sampleRate = 0.0;
+    };
+
+    static_assert (offsetof (Header, segmentMagic) == 0, "The magic must overlay the legacy writeIndex");
+
+    // The clock anchors are taken on: steady_clock, which is CLOCK_MONOTONIC on Linux and
+    // CLOCK_UPTIME_RAW on macOS, so every process on the machine reads the same one.
+    inline int64_t monotonicNanos() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // One (frame, clock, musical position) point on the sender's timeline: frame `frame` belongs
+    // to clock reading `clockNs`, and later frames follow at the segment's sample rate. ppq is
+    // NaN while the sender's host isn't playing or doesn't say.
+    struct Anchor
+    {
+        uint64_t frame = 0;
+        int64_t clockNs = 0;
+        double ppq = 0.0;
+
+        bool hasPpq() const noexcept    { return ! std::isnan (ppq); }
+    };
+
+    // The shared copy, under a sequence count: odd while the sender is rewriting it, 0 until the
+    // first anchor. Only the sender writes it.
+    struct AnchorSlot
+    {
+        std::atomic<uint64_t> sequence { 0 };
+        std::atomic<uint64_t> frame { 0 };
+        std::atomic<int64_t> clockNs { 0 };
+        std::atomic<double> ppq { 0.0 };
+    };
+
+    // Version 1: every live field on the cache line after the descriptor. The sender's writeIndex
+    // store and the receiver's readIndex store land on the same line, so it moves between the two
+    // cores twice a block and each side's next read of it misses.
+    struct SegmentV1
+    {
+        Header descriptor;
+        alignas (64) std::atomic<uint64_t> writeIndex { 0 };
+        std::atomic<uint64_t> readIndex { 0 };
+        std::atomic<uint64_t> ringFormat { 0 };
+        std::atomic<uint32_t> isActive { 0 };
+        std::atomic<uint32_t> bufferUnderruns { 0 };
+        std::atomic<double> currentLatency { 0.0 };  // Milliseconds, written by the receiver
+    };
+
+    // Version 2: the sender's fields on one line and the receivers' on the next, so neither side
+    // writes to a line the other keeps reading; the receiver's copy of the sender's line only goes
+    // stale when the sender actually wrote to it. The sample area starts on a page boundary.
+    struct SegmentV2
+    {
+        Header descriptor;
+
+        // Written by the sender. The anchor shares the line writeIndex already pulls across.
+        alignas (64) std::atomic<uint64_t> writeIndex { 0 };
+        std::atomic<uint64_t> ringFormat { 0 };
+        std::atomic<uint32_t> isActive { 0 };
+        AnchorSlot anchor;
+
+        // Written by receivers.
+        alignas (64) std::atomic<uint64_t> readIndex { 0 };
+        std::atomic<double> currentLatency { 0.0 };  // Milliseconds
+        std::atomic<uint32_t> bufferUnderruns { 0 };
+    };
+
+    static_assert (offsetof (SegmentV1, writeIndex) == 64 && sizeof (SegmentV1) == 128, "Version 1 is fixed");
+    static_assert (offsetof (SegmentV2, readIndex) - offsetof (SegmentV2, writeIndex) == 64, "One line per side");
+
+    // Where the sample area starts. Version 2 rounds up to 16 KB, the largest page size in use
+    // (Apple silicon); 4 KB pages divide it.
+    inline uint32_t sampleAreaOffset (uint32_t layoutVersion) noexcept
+    {
+        return layoutVersion == 1 ? (uint32_t) sizeof (SegmentV1) : 16384u;
+    }
+
+    inline size_t liveFieldsEnd (uint32_t layoutVersion) noexcept
+    {
+        return layoutVersion == 1 ? sizeof (SegmentV1) : sizeof (SegmentV2);
+    }
+
+    // Pointers to a segment's live fields, whichever version it is.
+    struct LiveFields
+    {
+        std::atomic<uint64_t>* writeIndex = nullptr;
+        std::atomic<uint64_t>* readIndex = nullptr;
+        std::atomic<uint64_t>* ringFormat = nullptr;
+        std::atomic<uint32_t>* isActive = nullptr;
+        std::atomic<uint32_t>* bufferUnderruns = nullptr;
+        std::atomic<double>* currentLatency = nullptr;
+        AnchorSlot* anchor = nullptr;    // Null before version 2
+    };
+
+    // For a header that passed validate() (or that describe() filled in).
+    inline LiveFields locate (Header& header) noexcept
+    {
+        if (header.layoutVersion == 1)
+        {
+            auto& segment = reinterpret_cast<SegmentV1&> (header);
+            return { &segment.writeIndex, &segment.readIndex, &segment.ringFormat,
+                     &segment.isActive, &segment.bufferUnderruns, &segment.currentLatency, nullptr };
+        }
+
+        auto& segment = reinterpret_cast<SegmentV2&> (header);
+        return { &segment.writeIndex, &segment.readIndex, &segment.ringFormat,
+                 &segment.isActive, &segment.bufferUnderruns, &segment.currentLatency, &segment.anchor };
+    }
+
+    // Sender side. Every block or every few is plenty; receivers extrapolate in between.
+    inline void publishAnchor (AnchorSlot& slot, const Anchor& anchor) noexcept
+    {
+        const uint64_t sequence = slot.sequence.load (std::memory_order_relaxed);
+        slot.sequence.store (sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        slot.frame.store (anchor.frame, std::memory_order_relaxed);
+        slot.clockNs.store (anchor.clockNs, std::memory_order_relaxed);
+        slot.ppq.store (anchor.ppq, std::memory_order_relaxed);
+
+        slot.sequence.store (sequence + 2, std::memory_order_release);
+    }
+
+    // Receiver side. Returns the sequence count of the anchor read (0 if the sender never
+    // published one, or it was being rewritten on every try), so a caller can skip one it has seen.
+    inline uint64_t readAnchor (const AnchorSlot& slot, Anchor& anchor) noexcept
+    {
+        for (int attempt = 0; attempt < 4; ++attempt)
+        {
+            const uint64_t before = slot.sequence.load (std::memory_order_acquire);
+
+            if (before == 0)
+                return 0;
+
+            if ((before & 1) != 0)
+                continue;
+
+            anchor.frame = slot.frame.load (std::memory_order_relaxed);
+            anchor.clockNs = slot.clockNs.load (std::memory_order_relaxed);
+            anchor.ppq = slot.ppq.load (std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_acquire);
+
+            if (slot.sequence.load (std::memory_order_relaxed) == before)
+                return before;
+        }
+
+        return 0;
+    }
+
+    // Sender side: fills in a zeroed header. Publish with publish() once the rest is ready.
+    inline void describe (Header& header, uint64_t ringFrames, uint32_t numChannels, double sampleRate,
+                          uint32_t layoutVersion = version) noexcept
+    {
+        header.layoutVersion = layoutVersion;
+        header.headerBytes = sampleAreaOffset (layoutVersion);
+        header.numChannels = numChannels;
+        header.ringFrames = ringFrames;
+        header.sampleAreaBytes = ringFrames * numChannels * (uint64_t) SampleFormat::bytesPerSample (SampleFormat::float32);
+        header.segmentBytes = header.headerBytes + header.sampleAreaBytes;
+        header.sampleRate = sampleRate;
+    }
+
+    inline void publish (Header& header) noexcept
+    {
+        header.segmentMagic.store (magic, std::memory_order_release);
+    }
+
+    // Receiver side: checks a header whose magic matched against the segment's actual size.
+    // Returns null if it is usable, otherwise a short reason.
+    inline const char* validate (const Header& header, uint64_t fileBytes) noexcept
+    {
+        if (header.layoutVersion < oldestVersion || header.layoutVersion > version)
+            return header.layoutVersion > version ? "newer segment layout" : "unknown segment layout";
+
+        if (header.numChannels == 0 || header.numChannels > maxChannels)
+            return "unsupported channel count";
+
+        if (header.ringFrames < minRingFrames || header.ringFrames > maxRingFrames
+            || (header.ringFrames & (header.ringFrames - 1)) != 0)
+            return "unsupported ring size";
+
+        if (header.headerBytes < liveFieldsEnd (header.layoutVersion) || header.headerBytes % 64 != 0)
+            return "bad header size";
+
+        if (header.sampleAreaBytes < header.ringFrames * header.numChannels * (uint64_t) SampleFormat::bytesPerSample (SampleFormat::int16)
+            || header.segmentBytes != header.headerBytes + header.sampleAreaBytes)
+            return "inconsistent sizes";
+
+        if (fileBytes < header.segmentBytes)
+            return "segment shorter than advertised";
+
+        if (! (header.sampleRate > 0.0))
+            return "missing sample rate";
+
+        return nullptr;
+    }
+}
@@ -0,0 +1,342 @@
+#include "SharedConnection.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    std::atomic<uint64_t> nextConnectionId { 1 };
+
+    constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+    // Maps `fd` at an address aligned to `alignment`: reserve a larger anonymous range, map the
+    // segment over an aligned spot inside it, and hand back the slack on either side.
+    void* mapAligned(size_t size, int protection, int flags, int fd, size_t alignment)
+    {
+        void* reserved = mmap(nullptr, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (reserved == MAP_FAILED)
+            return MAP_FAILED;
+
+        const auto base = reinterpret_cast<uintptr_t>(reserved);
+        const auto aligned = (base + alignment - 1) & ~(uintptr_t) (alignment - 1);
+
+        void* mapped = mmap(reinterpret_cast<void*>(aligned), size, protection, flags | MAP_FIXED, fd, 0);
+
+        if (mapped == MAP_FAILED)
+        {
+            munmap(reserved, size + alignment);
+            return MAP_FAILED;
+        }
+
+        if (aligned > base)
+            munmap(reserved, aligned - base);
+
+        const uintptr_t end = aligned + size, reservedEnd = base + size + alignment;
+
+        if (reservedEnd > end)
+            munmap(reinterpret_cast<void*>(end), reservedEnd - end);
+
+        return mapped;
+    }
+
+   #if JUCE_LINUX
+    // Reads a one-line sysfs setting such as "always [within_size] advise never deny" and returns
+    // the bracketed choice.
+    std::string readSelectedSetting(const char* path)
+    {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+
+        const auto open = line.find('['), close = line.find(']');
+        return open != std::string::npos && close > open ? line.substr(open + 1, close - open - 1) : std::string();
+    }
+
+    // True if the kernel maps part of the range starting at `base` with PMD-sized (huge) pages.
+    bool isHugePageMapped(const void* base)
+    {
+        std::ifstream smaps("/proc/self/smaps");
+        std::string line;
+        bool inRange = false;
+        const auto start = reinterpret_cast<uintptr_t>(base);
+
+        while (std::getline(smaps, line))
+        {
+            // Range headers look like "7f0a3c000000-7f0a3c200000 rw-s ..."; attribute lines don't
+            // start with a hex digit followed by '-'.
+            const auto dash = line.find('-');
+
+            if (dash != std::string::npos && dash > 0 && line.find(' ') > dash && std::isxdigit((unsigned char) line[0]))
+            {
+                inRange = std::strtoull(line.c_str(), nullptr, 16) == start;
+                continue;
+            }
+
+            if (inRange && (line.rfind("ShmemPmdMapped:", 0) == 0 || line.rfind("FilePmdMapped:", 0) == 0)
+                && std::strtoull(line.c_str() + line.find(':') + 1, nullptr, 10) > 0)
+                return true;
+        }
+
+        return false;
+    }
+   #endif
+}
+
+juce::StringArray SharedConnection::MappingReport::describe() const
+{
+    juce::StringArray lines;
+
+    auto add = [&lines](const char* step, StepResult result, const juce::String& reason)
+    {
+        if (result == StepResult::notRequested)
+            lines.add(juce::String(step) + ": off");
+        else if (result == StepResult::succeeded)
+            lines.add(juce::String(step) + ": ok");
+        else
+            lines.add(juce::String(step) + ": failed" + (reason.isNotEmpty() ? " (" + reason + ")" : juce::String()));
+    };
+
+    add("Pre-faulted", prefault, {});
+    add("Pages locked", lockPages, lockError);
+    add("Huge pages", hugePages, hugePageNote);
+    return lines;
+}
+
+SharedConnection::~SharedConnection()
+{
+    readers.detach();
+
+    if (base != nullptr)
+        munmap(base, mappedSize);
+
+    if (fd != -1)
+        close(fd);
+}
+
+//Will first try to open the shared memory with read-write permission. If that fails, it falls back to read-only mode.
+std::unique_ptr<SharedConnection> SharedConnection::open(const juce::String& streamName, const MappingOptions& options,
+                                                         juce::String* failureReason)
+{
+    std::unique_ptr<SharedConnection> connection(new SharedConnection());
+    juce::String reason;
+
+    // First attempt to open the shared memory with read-write access
+    connection->fd = shm_open(streamName.toRawUTF8(), O_RDWR, 0666);
+    connection->writable = connection->fd != -1;
+
+    if (connection->fd == -1)
+    {
+        DBG("Failed to open shared memory with read-write access: " + juce::String(strerror(errno)));
+
+        // Try again with read-only as fallback
+        connection->fd = shm_open(streamName.toRawUTF8(), O_RDONLY, 0666);
+
+        if (connection->fd == -1)
+        {
+            DBG("Failed to open shared memory: " + juce::String(strerror(errno)));
+
+            if (failureReason != nullptr)
+                *failureReason = juce::String(strerror(errno));
+
+            return nullptr;
+        }
+    }
+
+    if (!connection->mapSegment(options, reason))
+    {
+        DBG("Failed to map shared memory: " + reason);
+
+        if (failureReason != nullptr)
+            *failureReason = reason;
+
+        return nullptr; // Destructor unmaps and closes the descriptor
+    }
+
+    connection->id = nextConnectionId.fetch_add(1);
+    connection->prepareMapping(options);
+
+    DBG(juce::String("Connected to shared memory in ") + (connection->writable ? "READ-WRITE" : "READ-ONLY") + " mode"
+        + (connection->header != nullptr ? ", layout v" + juce::String(connection->header->layoutVersion) : juce::String()));
+
+    // Register as a reader so other receivers on this stream don't clobber our cursor.
+    if (!connection->readers.attach(streamName.toStdString()))
+        DBG("Reader table unavailable, falling back to the shared readIndex only");
+
+    return connection;
+}
+
+// Works out which layout the segment has, maps exactly as much of it as that layout says, and
+// fills in the shape the accessors use.
+bool SharedConnection::mapSegment(const MappingOptions& options, juce::String& failureReason)
+{
+    struct stat info {};
+
+    if (fstat(fd, &info) != 0)
+    {
+        failureReason = juce::String(strerror(errno));
+        return false;
+    }
+
+    const auto fileBytes = (uint64_t) info.st_size;
+    const auto pageSize = (uint64_t) sysconf(_SC_PAGESIZE);
+
+    // Peek at the descriptor before mapping anything. The sender stores the magic last, so if it
+    // is there the rest of the descriptor is too; it is checked again in the mapping below.
+    SegmentLayout::Header peeked;
+    const bool hasHeader = fileBytes >= sizeof(SegmentLayout::Header)
+                           && pread(fd, &peeked, sizeof(peeked), 0) == (ssize_t) sizeof(peeked)
+                           && peeked.segmentMagic.load() == SegmentLayout::magic;
+
+    size_t bytesToMap = 0;
+
+    if (hasHeader)
+    {
+        if (auto* problem = SegmentLayout::validate(peeked, fileBytes))
+        {
+            failureReason = problem;
+            return false;
+        }
+
+        bytesToMap = (size_t) peeked.segmentBytes;
+    }
+    else if (fileBytes >= MAX_BUFFER_SIZE && fileBytes < MAX_BUFFER_SIZE + pageSize)
+    {
+        // Exactly a SharedAudioData, give or take page rounding: a legacy sender.
+        bytesToMap = MAX_BUFFER_SIZE;
+    }
+    else
+    {
+        // Most likely a self-describing sender that hasn't published its header yet; the next
+        // attempt will see it.
+        failureReason = fileBytes == 0 ? "segment not sized yet" : "unrecognised segment layout";
+        return false;
+    }
+
+    const int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    int flags = MAP_SHARED;
+
+   #ifdef MAP_POPULATE
+    if (options.prefault)
+        flags |= MAP_POPULATE; // The kernel faults everything in now, on this thread
+   #endif
+
+    // Huge pages need the mapping on a 2 MB boundary; fall back to a plain mapping if that fails.
+    void* mappedMemory = options.hugePages ? mapAligned(bytesToMap, protection, flags, fd, hugePageSize) : MAP_FAILED;
+
+    if (mappedMemory == MAP_FAILED)
+        mappedMemory = mmap(0, bytesToMap, protection, flags, fd, 0);
+
+    if (mappedMemory == MAP_FAILED)
+    {
+        failureReason = juce::String(strerror(errno));
+        return false;
+    }
+
+    base = mappedMemory;
+    mappedSize = bytesToMap;
+
+    if (!hasHeader)
+    {
+        data = static_cast<SharedAudioData*>(base);
+        samples = reinterpret_cast<const uint8_t*>(data->audioData);
+        ringMask = SharedAudioData::BUFFER_MASK;
+        numChannels = legacyNumChannels;
+        maxBytesPerSample = sizeof(float);
+        return true;
+    }
+
+    auto* mappedHeader = static_cast<SegmentLayout::Header*>(base);
+
+    // The sender may have been replaced between the peek and the mapping.
+    if (mappedHeader->segmentMagic.load(std::memory_order_acquire) != SegmentLayout::magic
+        || mappedHeader->segmentBytes != peeked.segmentBytes
+        || SegmentLayout::validate(*mappedHeader, fileBytes) != nullptr)
+    {
+        failureReason = "segment changed while connecting";
+        return false;
+    }
+
+    header = mappedHeader;
+    live = SegmentLayout::locate(*header);
+    samples = static_cast<const uint8_t*>(base) + header->headerBytes;
+    ringMask = header->ringFrames - 1;
+    numChannels = (int) header->numChannels;
+    maxBytesPerSample = (size_t) (header->sampleAreaBytes / (header->ringFrames * header->numChannels));
+    return true;
+}
+
+void SharedConnection::prepareMapping(const MappingOptions& options)
+{
+    // Never touch past the end of the segment: that would be SIGBUS, not a page fault.
+    struct stat info {};
+    const size_t segmentSize = fstat(fd, &info) == 0 ? (size_t) info.st_size : 0;
+    const size_t usable = juce::jmin(segmentSize, mappedSize);
+
+    if (options.hugePages)
+    {
+       #if JUCE_LINUX
+        // Shared memory is tmpfs, so it only gets huge pages if shmem THP allows it, and only for
+        // whole 2 MB extents of the segment.
+        const auto shmemSetting = readSelectedSetting("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+
+        if (madvise(base, mappedSize, MADV_HUGEPAGE) != 0)
+            mappingReport.hugePageNote = juce::String(strerror(errno));
+        else if (shmemSetting == "never" || shmemSetting == "deny" || shmemSetting.empty())
+            mappingReport.hugePageNote = "shmem_enabled is " + juce::String(shmemSetting.empty() ? "unavailable" : shmemSetting);
+        else if (usable < hugePageSize)
+            mappingReport.hugePageNote = "segment smaller than a huge page";
+       #else
+        mappingReport.hugePageNote = "not supported for shared memory here";
+       #endif
+    }
+
+    if (options.prefault)
+    {
+        // MAP_POPULATE already did this on Linux; elsewhere this pass does the faulting. Either
+        // way every page is in our page tables before processBlock reads it.
+        const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+        const volatile uint8_t* bytes = reinterpret_cast<const volatile uint8_t*>(base);
+        uint8_t sink = 0;
+
+        for (size_t offset = 0; offset < usable; offset += pageSize)
+            sink ^= bytes[offset];
+
+        juce::ignoreUnused(sink);
+        mappingReport.prefault = usable == mappedSize ? StepResult::succeeded : StepResult::failed;
+    }
+
+    if (options.lockPages)
+    {
+        if (mlock(base, usable) == 0)
+        {
+            mappingReport.lockPages = StepResult::succeeded;
+        }
+        else
+        {
+            mappingReport.lockPages = StepResult::failed;
+            mappingReport.lockError = juce::String(strerror(errno));
+        }
+    }
+
+    // Checked last: faulting the pages in is what gives the kernel a chance to use huge ones.
+    if (options.hugePages)
+    {
+       #if JUCE_LINUX
+        const bool huge = mappingReport.hugePageNote.isEmpty() && isHugePageMapped(base);
+
+        if (!huge && mappingReport.hugePageNote.isEmpty())
+            mappingReport.hugePageNote = "kernel used small pages";
+
+        mappingReport.hugePages = huge ? StepResult::succeeded : StepResult::failed;
+       #else
+        mappingReport.hugePages = StepResult::failed;
+       #endif
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedMemoryManager.h"
+#include "ReaderRegistry.h"
+#include "SegmentHeader.h"
+#include "FrameWaiter.h"
+
+// Everything the audio thread touches for one connection to a sender stream: the mapped segment,
+// its descriptor, and our slot in that stream's reader table.
+//
+// The segment is either the legacy SharedAudioData, whose shape is fixed at compile time, or a
+// self-describing one (see SegmentHeader.h) that carries its own channel count, ring size and
+// sample rate. open() tells them apart by the magic word at offset 0 and the accessors below hide
+// the difference, so nothing else should reach into either layout directly.
+//
+// A connection is built completely on the message thread, handed to the audio thread through
+// ConnectionHandoff, and destroyed (unmapped) on the message thread once the audio thread has let
+// go of it. The mapping never changes after open() returns. The reader slot can: the message
+// thread's reapDeadReaders() claims a fresh one on the live connection if ours was reclaimed,
+// while the audio thread keeps publishing through ReaderRegistry, which is safe for that.
+//
+// open() can also get the mapping ready for real-time use before the audio thread touches it:
+// pre-faulting every page, locking them in RAM and asking for huge pages, so the first blocks
+// after a connect don't take page faults and TLB misses. Each step is best effort; the report
+// says which ones worked.
+class SharedConnection
+{
+public:
+    struct MappingOptions
+    {
+        bool prefault = true;      // MAP_POPULATE where available, then read one byte per page
+        bool lockPages = false;    // mlock the mapping (limited by RLIMIT_MEMLOCK)
+        bool hugePages = true;     // 2 MB aligned mapping plus MADV_HUGEPAGE (Linux only)
+    };
+
+    enum class StepResult { notRequested, succeeded, failed };
+
+    struct MappingReport
+    {
+        StepResult prefault = StepResult::notRequested;
+        StepResult lockPages = StepResult::notRequested;
+        StepResult hugePages = StepResult::notRequested;
+        juce::String lockError;    // Why mlock failed
+        juce::String hugePageNote; // Why the mapping isn't huge-page backed
+
+        bool anyFailed() const noexcept
+        {
+            return prefault == StepResult::failed || lockPages == StepResult::failed || hugePages == StepResult::failed;
+        }
+
+        // One line per requested step, e.g. "Pages locked: failed (Cannot allocate memory)".
+        juce::StringArray describe() const;
+    };
+
+    // Samples per frame in a legacy segment (the first two are unused).
+    static constexpr int legacyNumChannels = 10;
+
+    ~SharedConnection();
+
+    // Opens and maps the stream read-write, falling back to read-only. Returns null on failure,
+    // with the reason in failureReason if given.
+    static std::unique_ptr<SharedConnection> open(const juce::String& streamName, const MappingOptions& options,
+                                                  juce::String* failureReason = nullptr);
+
+    // Null for a self-describing segment.
+    SharedAudioData* getData() const noexcept       { return data; }
+
+    // 0 for a legacy segment, otherwise the header's layout version.
+    uint32_t getLayoutVersion() const noexcept      { return header != nullptr ? header->layoutVersion : 0; }
+    int getNumChannels() const noexcept             { return numChannels; }   // Samples per frame, dummies included
+    uint64_t getRingMask() const noexcept           { return ringMask; }
+    double getSampleRate() const noexcept           { return header != nullptr ? header->sampleRate : 0.0; } // 0 if unknown
+    const uint8_t* getSamples() const noexcept      { return samples; }
+
+    // Widest encoding the sample area has room for at the full ring size.
+    size_t getMaxBytesPerSample() const noexcept    { return maxBytesPerSample; }
+
+    //==============================================================================
+    // Audio thread. The stores need a writable mapping.
+    uint64_t loadWriteIndex() const noexcept
+    {
+        return header != nullptr ? live.writeIndex->load(std::memory_order_acquire)
+                                 : (uint64_t) data->writeIndex.load(std::memory_order_acquire);
+    }
+
+    // Offline rendering only: blocks until writeIndex reaches `frame` or timeoutMs runs out, and
+    // returns the last index seen (see FrameWaiter.h). A legacy segment's writeIndex is declared in
+    // the sender's shared header, not here, so it is polled rather than waited on.
+    uint64_t waitForWriteIndex(uint64_t frame, double timeoutMs) const noexcept
+    {
+        return FrameWaiter::waitFor(header != nullptr ? live.writeIndex : nullptr,
+                                    [this] { return loadWriteIndex(); }, frame, timeoutMs);
+    }
+
+    bool isSenderActive() const noexcept
+    {
+        return header != nullptr ? live.isActive->load(std::memory_order_acquire) != 0 : data->isActive.load();
+    }
+
+    // Legacy segments keep the format record in the reader table, self-describing ones in the header.
+    ReaderTableLayout::RingFormat getRingFormat() const noexcept
+    {
+        return header != nullptr ? ReaderTableLayout::unpackRingFormat(live.ringFormat->load(std::memory_order_acquire))
+                                 : readers.getRingFormat();
+    }
+
+    // The sender's latest time anchor (version 2 segments and up). Returns its sequence count, 0
+    // if there is none to be had.
+    uint64_t readAnchor(SegmentLayout::Anchor& anchor) const noexcept
+    {
+        return live.anchor != nullptr ? SegmentLayout::readAnchor(*live.anchor, anchor) : 0;
+    }
+
+    void storeReadIndex(uint64_t readIndex) noexcept
+    {
+        if (header != nullptr)
+            live.readIndex->store(readIndex, std::memory_order_release);
+        else
+            data->readIndex.store(readIndex, std::memory_order_release);
+    }
+
+    void storeLatency(double latencyMs) noexcept
+    {
+        if (header != nullptr)
+            live.currentLatency->store(latencyMs, std::memory_order_relaxed);
+        else
+            data->metrics.currentLatency.store(latencyMs, std::memory_order_relaxed);
+    }
+
+    void addUnderrun() noexcept
+    {
+        if (header != nullptr)
+            live.bufferUnderruns->fetch_add(1, std::memory_order_relaxed);
+        else
+            data->metrics.bufferUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    int getFileDescriptor() const noexcept          { return fd; }
+    bool isWritable() const noexcept                { return writable; }
+    ReaderRegistry& getReaders() noexcept           { return readers; }
+    const ReaderRegistry& getReaders() const noexcept { return readers; }
+
+    // Unique per connection, so the audio thread can tell a new mapping from the old one even if
+    // the allocator hands back the same address.
+    uint64_t getId() const noexcept                 { return id; }
+
+    const MappingReport& getMappingReport() const noexcept { return mappingReport; }
+
+private:
+    SharedConnection() = default;
+
+    void prepareMapping(const MappingOptions& options);
+    bool mapSegment(const MappingOptions& options, juce::String& failureReason);
+
+    void* base = nullptr;
+    size_t mappedSize = 0;
+    SharedAudioData* data = nullptr;
+    SegmentLayout::Header* header = nullptr;
+    SegmentLayout::LiveFields live;     // Into *header, wherever its version puts them
+    const uint8_t* samples = nullptr;
+    uint64_t ringMask = 0;
+    int numChannels = 0;
+    size_t maxBytesPerSample = 0;
+    int fd = -1;
+    bool writable = false;
+    uint64_t id = 0;
+    ReaderRegistry readers;
+    MappingReport mappingReport;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedConnection)
+};
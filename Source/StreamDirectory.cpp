@@ -0,0 +1,269 @@
+#include "StreamDirectory.h"
+#include "ReaderRegistry.h"
+#include "Doorbell.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    std::atomic<uint32_t> nextPublisherId { 1 };
+
+    bool isOwnerAlive(uint64_t owner)
+    {
+        const pid_t pid = (pid_t) (owner >> 32);
+        return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+    }
+
+    void copyText(char* dest, size_t destSize, const std::string& source)
+    {
+        const size_t length = std::min(source.size(), destSize - 1);
+        std::memcpy(dest, source.data(), length);
+        std::memset(dest + length, 0, destSize - length);
+    }
+}
+
+StreamDirectory::~StreamDirectory()
+{
+    detach();
+}
+
+bool StreamDirectory::attach()
+{
+    if (directory != nullptr)
+        return true;
+
+    fd = shm_open(StreamDirectoryLayout::segmentName, O_RDWR | O_CREAT, 0666);
+
+    if (fd == -1)
+        return false;
+
+    struct stat info {};
+    if (fstat(fd, &info) == -1
+        || ((size_t) info.st_size < sizeof(StreamDirectoryLayout::Directory)
+            && ftruncate(fd, (off_t) sizeof(StreamDirectoryLayout::Directory)) == -1))
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, sizeof(StreamDirectoryLayout::Directory), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mapped == MAP_FAILED)
+    {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    auto* newDirectory = static_cast<StreamDirectoryLayout::Directory*>(mapped);
+
+    uint32_t expected = 0;
+    newDirectory->directoryMagic.compare_exchange_strong(expected, StreamDirectoryLayout::magic);
+
+    if (newDirectory->directoryVersion.load() == 0)
+        newDirectory->directoryVersion.store(StreamDirectoryLayout::version);
+
+    if (newDirectory->directoryMagic.load() != StreamDirectoryLayout::magic
+        || newDirectory->directoryVersion.load() != StreamDirectoryLayout::version)
+    {
+        munmap(mapped, sizeof(StreamDirectoryLayout::Directory));
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    directory = newDirectory;
+    return true;
+}
+
+void StreamDirectory::detach()
+{
+    withdraw();
+
+    if (directory != nullptr)
+    {
+        munmap(directory, sizeof(StreamDirectoryLayout::Directory));
+        directory = nullptr;
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+std::vector<StreamDirectory::StreamInfo> StreamDirectory::listLiveStreams() const
+{
+    std::vector<StreamInfo> streams;
+
+    if (directory == nullptr)
+        return streams;
+
+    const uint64_t now = ReaderTableLayout::nowMs();
+
+    for (auto& entry : directory->entries)
+    {
+        const uint64_t owner = entry.owner.load(std::memory_order_acquire);
+
+        if (owner == 0)
+            continue;
+
+        const uint64_t heartbeat = entry.heartbeatMs.load(std::memory_order_acquire);
+
+        if (now > heartbeat && now - heartbeat > StreamDirectoryLayout::staleAfterMs)
+            continue;
+
+        if (!isOwnerAlive(owner))
+            continue;
+
+        // Sequence-locked copy of the text fields; give up on an entry being rewritten right now.
+        StreamInfo info;
+        char name[StreamDirectoryLayout::maxNameLength];
+        char label[StreamDirectoryLayout::maxLabelLength];
+        bool consistent = false;
+
+        for (int attempt = 0; attempt < 4 && !consistent; ++attempt)
+        {
+            const uint32_t before = entry.sequence.load(std::memory_order_acquire);
+
+            if ((before & 1) != 0)
+                continue;
+
+            std::memcpy(name, entry.name, sizeof(name));
+            std::memcpy(label, entry.label, sizeof(label));
+            info.numChannels = (int) entry.numChannels;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            consistent = entry.sequence.load(std::memory_order_relaxed) == before;
+        }
+
+        if (!consistent)
+            continue;
+
+        name[sizeof(name) - 1] = 0;
+        label[sizeof(label) - 1] = 0;
+        info.name = name;
+        info.label = label;
+        info.owner = owner;
+
+        if (!info.name.empty())
+            streams.push_back(std::move(info));
+    }
+
+    std::sort(streams.begin(), streams.end(),
+              [](const StreamInfo& a, const StreamInfo& b) { return a.name < b.name; });
+    return streams;
+}
+
+bool StreamDirectory::publish(const std::string& name, const std::string& label, int numChannels)
+{
+    withdraw();
+
+    if (!attach())
+        return false;
+
+    if (token == 0)
+        token = ((uint64_t) (uint32_t) getpid() << 32) | nextPublisherId.fetch_add(1);
+
+    const uint64_t now = ReaderTableLayout::nowMs();
+
+    for (auto& entry : directory->entries)
+    {
+        uint64_t owner = entry.owner.load();
+
+        // Free entries, and entries whose sender died or went silent, can be taken over.
+        const uint64_t heartbeat = entry.heartbeatMs.load();
+        const bool stale = owner != 0 && (!isOwnerAlive(owner)
+                                          || (now > heartbeat && now - heartbeat > StreamDirectoryLayout::staleAfterMs));
+
+        if ((owner == 0 || stale) && entry.owner.compare_exchange_strong(owner, token))
+        {
+            entry.sequence.fetch_add(1, std::memory_order_acq_rel);
+            copyText(entry.name, sizeof(entry.name), name);
+            copyText(entry.label, sizeof(entry.label), label);
+            entry.numChannels = (uint32_t) numChannels;
+            entry.sequence.fetch_add(1, std::memory_order_release);
+
+            entry.heartbeatMs.store(now, std::memory_order_release);
+            publishedEntry = &entry;
+            Doorbell::ring(directory->changes);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StreamDirectory::heartbeat() noexcept
+{
+    if (publishedEntry != nullptr && publishedEntry->owner.load(std::memory_order_relaxed) == token)
+        publishedEntry->heartbeatMs.store(ReaderTableLayout::nowMs(), std::memory_order_release);
+}
+
+void StreamDirectory::withdraw()
+{
+    if (publishedEntry == nullptr)
+        return;
+
+    uint64_t expected = token;
+    publishedEntry->owner.compare_exchange_strong(expected, 0);
+    publishedEntry = nullptr;
+
+    if (directory != nullptr)
+        Doorbell::ring(directory->changes);
+}
+
+uint32_t StreamDirectory::getChangeCount() const noexcept
+{
+    return directory != nullptr ? directory->changes.load(std::memory_order_acquire) : 0;
+}
+
+bool StreamDirectory::waitForChange(uint32_t lastSeen, int timeoutMs) const noexcept
+{
+    if (directory == nullptr)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+        return false;
+    }
+
+    return Doorbell::wait(directory->changes, lastSeen, timeoutMs);
+}
+
+void StreamDirectory::wakeWaiters() const noexcept
+{
+    if (directory != nullptr)
+        Doorbell::wakeAll(directory->changes);
+}
+
+std::string StreamDirectory::sanitiseName(const std::string& input)
+{
+    std::string name;
+
+    for (char c : input)
+    {
+        const bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                             || c == '_' || c == '-' || c == '.';
+
+        if (allowed)
+            name += c;
+        else if (c == ' ')
+            name += '_';
+    }
+
+    if (name.empty())
+        return {};
+
+    // Leave room for the leading slash, the reader table's "_rd" suffix and the terminator.
+    name = "/" + name.substr(0, (size_t) StreamDirectoryLayout::maxNameLength - 5);
+    return name;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Discovery index for named audio streams.
+//
+// Each sender publishes its audio segment under its own name (one per track group) and registers
+// that name in a fixed, well-known directory segment. Receivers read the directory to see which
+// streams are live, instead of probing shm_open with guessed names.
+//
+// Entries are claimed with a CAS on `owner`, the text fields are written under a sequence lock
+// (odd while being written), and senders refresh `heartbeatMs` at least once a second. An entry
+// counts as live while its heartbeat is fresh and its process is still running. Like the reader
+// table, all-zero memory is a valid empty directory.
+//
+// `changes` is a doorbell (see Doorbell.h): senders ring it after publishing or withdrawing an
+// entry, so receivers can sleep until a stream appears instead of retrying shm_open on a timer. A
+// sender should create its audio segment and set isActive before publishing its entry, so that a
+// woken receiver finds the segment ready. Heartbeats don't ring it.
+namespace StreamDirectoryLayout
+{
+    static constexpr const char* segmentName = "/AudioTransportStreams";
+    static constexpr uint32_t magic = 0x41525344;   // 'ARSD'
+    static constexpr uint32_t version = 1;
+    static constexpr int maxStreams = 64;
+    static constexpr int maxNameLength = 32;        // Including the terminator; macOS caps shm names at 31
+    static constexpr int maxLabelLength = 48;
+    static constexpr uint64_t staleAfterMs = 3000;
+
+    struct alignas (64) Entry
+    {
+        std::atomic<uint64_t> owner { 0 };          // 0 = free, otherwise (pid << 32) | per-process instance
+        std::atomic<uint64_t> heartbeatMs { 0 };
+        std::atomic<uint32_t> sequence { 0 };       // Odd while name/label/channels are being rewritten
+        uint32_t numChannels = 0;
+        char name[maxNameLength] {};
+        char label[maxLabelLength] {};
+    };
+
+    struct Directory
+    {
+        alignas (64) std::atomic<uint32_t> directoryMagic { 0 };
+        std::atomic<uint32_t> directoryVersion { 0 };
+        std::atomic<uint32_t> changes { 0 };        // Doorbell, bumped on every publish/withdraw
+
+        Entry entries[maxStreams];
+    };
+}
+
+//==============================================================================
+// Handle on the directory segment. Receivers list streams; a sender can also publish one entry.
+class StreamDirectory
+{
+public:
+    struct StreamInfo
+    {
+        std::string name;      // Shared-memory segment name, as passed to shm_open
+        std::string label;     // Free text from the sender, e.g. the track group
+        int numChannels = 0;
+        uint64_t owner = 0;    // Changes whenever the stream is re-published, e.g. by a restarted sender
+    };
+
+    StreamDirectory() = default;
+    ~StreamDirectory();
+
+    // Maps the directory, creating it if this is the first process to look. Safe to call repeatedly.
+    bool attach();
+    void detach();
+
+    // Live streams, sorted by name.
+    std::vector<StreamInfo> listLiveStreams() const;
+
+    // Doorbell: a counter that moves whenever an entry is published or withdrawn.
+    // waitForChange() blocks (without polling where the platform allows) until the counter differs
+    // from lastSeen or the timeout expires; wakeWaiters() makes blocked waiters re-check early.
+    uint32_t getChangeCount() const noexcept;
+    bool waitForChange (uint32_t lastSeen, int timeoutMs) const noexcept;
+    void wakeWaiters() const noexcept;
+
+    // Sender side: claim an entry for `name`, refresh it at least once a second, withdraw on exit.
+    bool publish (const std::string& name, const std::string& label, int numChannels);
+    void heartbeat() noexcept;
+    void withdraw();
+
+    // Turns user input into a valid POSIX shared-memory name ("/name", no other slashes, short
+    // enough for macOS). Returns an empty string if nothing usable is left.
+    static std::string sanitiseName (const std::string& input);
+
+private:
+    int fd = -1;
+    StreamDirectoryLayout::Directory* directory = nullptr;
+    StreamDirectoryLayout::Entry* publishedEntry = nullptr;
+    uint64_t token = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "StreamDirectory.h"
+
+// Sleeps on the stream directory's doorbell and calls onStreamsChanged on the message thread
+// whenever a sender publishes or withdraws a stream. Idle cost is one blocked thread; there is no
+// polling of shm_open.
+class StreamWatcher : private juce::Thread, private juce::AsyncUpdater
+{
+public:
+    explicit StreamWatcher (const StreamDirectory& directoryToWatch)
+        : juce::Thread ("AudioReceiver stream watcher"), directory (directoryToWatch)
+    {
+    }
+
+    ~StreamWatcher() override
+    {
+        stop();
+    }
+
+    // Message thread.
+    void start()
+    {
+        startThread();
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        directory.wakeWaiters();
+        stopThread (2000);
+        cancelPendingUpdate();
+    }
+
+    // Message thread: the last directory change count the watcher reported.
+    uint32_t getChangeCount() const noexcept    { return reportedChanges.load(); }
+
+    std::function<void()> onStreamsChanged;
+
+private:
+    void run() override
+    {
+        uint32_t lastSeen = directory.getChangeCount();
+
+        while (! threadShouldExit())
+        {
+            // The timeout only bounds how long a missed wake could go unnoticed; a ring or
+            // wakeWaiters() ends the wait immediately.
+            if (! directory.waitForChange (lastSeen, 5000))
+                continue;
+
+            lastSeen = directory.getChangeCount();
+            reportedChanges.store (lastSeen);
+            triggerAsyncUpdate();
+        }
+    }
+
+    void handleAsyncUpdate() override
+    {
+        if (onStreamsChanged != nullptr)
+            onStreamsChanged();
+    }
+
+    const StreamDirectory& directory;
+    std::atomic<uint32_t> reportedChanges { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (StreamWatcher)
+};
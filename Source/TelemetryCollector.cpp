@@ -0,0 +1,185 @@
+#include "TelemetryCollector.h"
+
+uint64_t TelemetryCollector::Histogram::total() const noexcept
+{
+    uint64_t sum = 0;
+
+    for (auto count : counts)
+        sum += count;
+
+    return sum;
+}
+
+uint64_t TelemetryCollector::Histogram::percentile(double p) const noexcept
+{
+    const uint64_t all = total();
+
+    if (all == 0)
+        return 0;
+
+    const uint64_t wanted = (uint64_t) std::ceil(juce::jlimit(0.0, 100.0, p) / 100.0 * (double) all);
+    uint64_t seen = 0;
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+    {
+        seen += counts[bucket];
+
+        if (seen >= wanted && counts[bucket] != 0)
+            return bucket + 1 < numBuckets ? lowerBound(bucket + 1) : lowerBound(bucket);
+    }
+
+    return lowerBound(numBuckets - 1);
+}
+
+//==============================================================================
+TelemetryCollector::TelemetryCollector(TelemetryRing& ringToDrain)
+    : juce::Thread("AudioReceiver telemetry"), ring(ringToDrain)
+{
+}
+
+TelemetryCollector::~TelemetryCollector()
+{
+    stop();
+}
+
+void TelemetryCollector::start()
+{
+    startThread(juce::Thread::Priority::background);
+}
+
+void TelemetryCollector::stop()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(1000);
+}
+
+void TelemetryCollector::run()
+{
+    // The ring holds a few seconds of blocks even at small buffer sizes; draining a few times a
+    // second keeps it far from full.
+    while (!threadShouldExit())
+    {
+        drainRing();
+        wait(200);
+    }
+}
+
+void TelemetryCollector::drainRing()
+{
+    const double rate = sampleRate.load();
+    const auto now = juce::Time::getCurrentTime();
+
+    const juce::ScopedLock sl(lock);
+
+    ring.drain([&](const TelemetryRing::Record& record)
+    {
+        ++totals.blocks;
+        totals.gap.add(record.gap);
+
+        // A block that waited for an offline sender spent most of its time asleep and has no
+        // real-time budget to blow, so it's kept out of the processing statistics.
+        if ((record.flags & TelemetryRing::waited) != 0)
+        {
+            totals.maxOfflineWaitNs = juce::jmax(totals.maxOfflineWaitNs, record.processingNs);
+        }
+        else
+        {
+            totals.processingMicros.add(record.processingNs / 1000);
+            totals.maxProcessingNs = juce::jmax(totals.maxProcessingNs, record.processingNs);
+
+            if (rate > 0.0 && record.numSamples > 0)
+            {
+                totals.budgetNs = (double) record.numSamples * 1.0e9 / rate;
+                totals.maxLoad = juce::jmax(totals.maxLoad, (double) record.processingNs / totals.budgetNs);
+            }
+        }
+
+        if ((record.flags & TelemetryRing::played) != 0)
+        {
+            ++totals.playedBlocks;
+            totals.fill.add(record.fill);
+        }
+
+        if ((record.flags & TelemetryRing::rebuffering) != 0)     ++totals.rebufferingBlocks;
+        if ((record.flags & TelemetryRing::disconnected) != 0)    ++totals.disconnectedBlocks;
+        if ((record.flags & TelemetryRing::underrun) != 0)        ++totals.underruns;
+        if ((record.flags & TelemetryRing::resync) != 0)          ++totals.resyncs;
+        if ((record.flags & TelemetryRing::concealed) != 0)       ++totals.concealments;
+        if ((record.flags & TelemetryRing::waited) != 0)          ++totals.offlineWaits;
+
+        if ((record.flags & (TelemetryRing::underrun | TelemetryRing::resync)) != 0)
+        {
+            // Timestamped when drained, so accurate to the drain interval.
+            if ((int) totals.recentEvents.size() >= maxRecentEvents)
+                totals.recentEvents.erase(totals.recentEvents.begin());
+
+            totals.recentEvents.push_back({ now, record.flags, record.gap, record.fill });
+        }
+    });
+
+    totals.droppedRecords = ring.getNumDropped();
+}
+
+TelemetryCollector::Snapshot TelemetryCollector::getSnapshot() const
+{
+    const juce::ScopedLock sl(lock);
+    return totals;
+}
+
+void TelemetryCollector::reset()
+{
+    const juce::ScopedLock sl(lock);
+    totals = Snapshot();
+}
+
+bool TelemetryCollector::dumpToFile(const juce::File& file) const
+{
+    const auto snapshot = getSnapshot();
+    juce::String text;
+
+    text << "AudioReceiver telemetry, " << juce::Time::getCurrentTime().toString(true, true) << juce::newLine << juce::newLine
+         << "blocks " << (juce::int64) snapshot.blocks
+         << ", played " << (juce::int64) snapshot.playedBlocks
+         << ", underruns " << (juce::int64) snapshot.underruns
+         << ", rebuffering " << (juce::int64) snapshot.rebufferingBlocks
+         << ", resyncs " << (juce::int64) snapshot.resyncs
+         << ", concealed " << (juce::int64) snapshot.concealments
+         << ", disconnected " << (juce::int64) snapshot.disconnectedBlocks
+         << ", waited for sender " << (juce::int64) snapshot.offlineWaits
+         << " (longest " << juce::String(snapshot.maxOfflineWaitNs / 1.0e6, 1) << " ms)"
+         << ", dropped records " << (juce::int64) snapshot.droppedRecords << juce::newLine
+         << "max processBlock " << juce::String(snapshot.maxProcessingNs / 1000.0, 1) << " us ("
+         << juce::String(snapshot.maxLoad * 100.0, 1) << "% of the block budget)" << juce::newLine;
+
+    auto writeHistogram = [&text](const char* title, const char* unit, const Histogram& histogram)
+    {
+        text << juce::newLine << title << " (" << unit << "), p50 " << (juce::int64) histogram.percentile(50.0)
+             << ", p99 " << (juce::int64) histogram.percentile(99.0) << ", p99.9 " << (juce::int64) histogram.percentile(99.9)
+             << juce::newLine;
+
+        for (int bucket = 0; bucket < Histogram::numBuckets; ++bucket)
+        {
+            if (histogram.counts[bucket] == 0)
+                continue;
+
+            text << "  >= " << juce::String((juce::int64) Histogram::lowerBound(bucket)).paddedLeft(' ', 8)
+                 << "  " << (juce::int64) histogram.counts[bucket] << juce::newLine;
+        }
+    };
+
+    writeHistogram("processBlock time", "us", snapshot.processingMicros);
+    writeHistogram("Ring fill after read", "frames", snapshot.fill);
+    writeHistogram("writeIndex - lastReadIndex at block start", "frames", snapshot.gap);
+
+    text << juce::newLine << "Recent underruns and resyncs" << juce::newLine;
+
+    for (const auto& event : snapshot.recentEvents)
+    {
+        text << "  " << event.time.toString(true, true, true, true) << "  "
+             << ((event.flags & TelemetryRing::resync) != 0 ? "resync  " : "underrun")
+             << "  gap " << (juce::int64) event.gap << ", fill " << (juce::int64) event.fill << juce::newLine;
+    }
+
+    return file.replaceWithText(text);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TelemetryRing.h"
+
+// Background consumer for the processor's TelemetryRing.
+//
+// A low-priority thread drains the ring a few times a second and folds every block into running
+// totals and log2 histograms (processing time, fill level, writeIndex - lastReadIndex gap). It also
+// keeps the last few underruns and resyncs with their wall-clock time, so a glitch in a long
+// session can be found afterwards. The editor polls getSnapshot(); dumpToFile() writes the same
+// figures as text.
+class TelemetryCollector : private juce::Thread
+{
+public:
+    // Bucket 0 counts zeros, bucket i counts values in [2^(i-1), 2^i); the last bucket is open-ended.
+    struct Histogram
+    {
+        static constexpr int numBuckets = 20;
+        uint64_t counts[numBuckets] {};
+
+        void add(uint64_t value) noexcept
+        {
+            int bucket = 0;
+
+            while (value != 0 && bucket < numBuckets - 1)
+            {
+                value >>= 1;
+                ++bucket;
+            }
+
+            ++counts[bucket];
+        }
+
+        static uint64_t lowerBound(int bucket) noexcept    { return bucket == 0 ? 0 : uint64_t(1) << (bucket - 1); }
+
+        uint64_t total() const noexcept;
+
+        // Upper edge of the bucket holding the p-th percentile (0-100).
+        uint64_t percentile(double p) const noexcept;
+    };
+
+    struct Event
+    {
+        juce::Time time;
+        uint32_t flags = 0;
+        uint32_t gap = 0;
+        uint32_t fill = 0;
+    };
+
+    struct Snapshot
+    {
+        Histogram processingMicros, fill, gap;
+
+        uint64_t blocks = 0, playedBlocks = 0, underruns = 0, rebufferingBlocks = 0, resyncs = 0, disconnectedBlocks = 0;
+        uint64_t concealments = 0, offlineWaits = 0;
+        uint64_t droppedRecords = 0;
+        uint32_t maxProcessingNs = 0;     // Blocks that waited for an offline sender don't count
+        uint32_t maxOfflineWaitNs = 0;    // Longest of those, wait included
+        double budgetNs = 0.0;            // Real-time budget of the most recent block
+        double maxLoad = 0.0;             // Worst processing time as a fraction of its block's budget
+
+        std::vector<Event> recentEvents;  // Oldest first
+    };
+
+    explicit TelemetryCollector(TelemetryRing& ringToDrain);
+    ~TelemetryCollector() override;
+
+    void start();
+    void stop();
+
+    // Any thread: the sample rate used to turn block sizes into time budgets.
+    void setSampleRate(double newSampleRate) { sampleRate.store(newSampleRate); }
+
+    Snapshot getSnapshot() const;
+    void reset();
+
+    // Writes the current snapshot as plain text. Returns false if the file couldn't be written.
+    bool dumpToFile(const juce::File& file) const;
+
+private:
+    void run() override;
+    void drainRing();
+
+    static constexpr int maxRecentEvents = 64;
+
+    TelemetryRing& ring;
+    std::atomic<double> sampleRate { 48000.0 };
+
+    juce::CriticalSection lock;
+    Snapshot totals;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryCollector)
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Per-block telemetry from processBlock, handed to a background consumer.
+//
+// Single producer (the audio thread), single consumer (TelemetryCollector). push() is wait-free:
+// one relaxed load of the consumer's position, a plain store of the record, one release store.
+// When the consumer falls behind the record is dropped and counted instead of blocking. Read and
+// write positions sit on separate cache lines so the two threads don't bounce one between them.
+class TelemetryRing
+{
+public:
+    enum Flags : uint32_t
+    {
+        played       = 1u << 0,  // Audio came out of the ring this block
+        underrun     = 1u << 1,  // Not enough frames: the block was silent and we rebuffer
+        rebuffering  = 1u << 2,  // Silent while waiting for the ring to reach the target fill
+        resync       = 1u << 3,  // The read cursor was moved (sender restart, overrun, new connection)
+        disconnected = 1u << 4,  // No active sender
+        concealed    = 1u << 5,  // A dropout started and was faded out (see UnderrunConcealer)
+        waited       = 1u << 6   // Offline render: blocked until the sender caught up
+    };
+
+    struct Record
+    {
+        uint32_t processingNs = 0;   // Wall time spent in processBlock
+        uint32_t numSamples = 0;
+        uint32_t gap = 0;            // writeIndex - lastReadIndex when the block started
+        uint32_t fill = 0;           // Frames left in the ring after this block's read
+        uint32_t flags = 0;
+        uint32_t targetFill = 0;
+    };
+
+    static constexpr uint32_t capacity = 4096;
+
+    // Audio thread.
+    void push (const Record& record) noexcept
+    {
+        const uint32_t write = writePosition.load (std::memory_order_relaxed);
+
+        if (write - readPosition.load (std::memory_order_acquire) >= capacity)
+        {
+            dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        records[write % capacity] = record;
+        writePosition.store (write + 1, std::memory_order_release);
+    }
+
+    // Consumer thread. Calls fn (const Record&) for everything pushed so far; returns the count.
+    template <typename Fn>
+    uint32_t drain (Fn&& fn)
+    {
+        const uint32_t write = writePosition.load (std::memory_order_acquire);
+        uint32_t read = readPosition.load (std::memory_order_relaxed);
+        const uint32_t count = write - read;
+
+        for (; read != write; ++read)
+            fn (records[read % capacity]);
+
+        readPosition.store (read, std::memory_order_release);
+        return count;
+    }
+
+    uint64_t getNumDropped() const noexcept   { return dropped.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Times a block and pushes its record when it goes out of scope, whichever way processBlock
+    // returns. Fill in the record's fields as they become known.
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (TelemetryRing& r, int numSamples) noexcept
+            : ring (r), start (std::chrono::steady_clock::now())
+        {
+            record.numSamples = (uint32_t) numSamples;
+        }
+
+        ~ScopedBlock()
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            record.processingNs = (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count();
+            ring.push (record);
+        }
+
+        Record record;
+
+    private:
+        TelemetryRing& ring;
+        const std::chrono::steady_clock::time_point start;
+
+        ScopedBlock (const ScopedBlock&) = delete;
+        ScopedBlock& operator= (const ScopedBlock&) = delete;
+    };
+
+private:
+    alignas (64) std::atomic<uint32_t> writePosition { 0 };
+    alignas (64) std::atomic<uint32_t> readPosition { 0 };
+    alignas (64) std::atomic<uint64_t> dropped { 0 };
+    Record records[capacity];
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TelemetryCollector.h"
+
+// Shows the telemetry collector's histograms: processBlock time, ring fill and the writeIndex -
+// lastReadIndex gap, each as log2 buckets, with the counters above them. The editor feeds it a
+// snapshot a couple of times a second; "Dump" writes the full figures to a text file and
+// "Capture" toggles recording the output to a WAV file.
+class TelemetryView : public juce::Component
+{
+public:
+    TelemetryView()
+    {
+        addAndMakeVisible(dumpButton);
+        dumpButton.setButtonText("Dump");
+        dumpButton.setTooltip("Write the telemetry to a text file in your Documents folder");
+        dumpButton.onClick = [this] { if (onDump != nullptr) onDump(); };
+
+        addAndMakeVisible(captureButton);
+        captureButton.setButtonText("Capture");
+        captureButton.setTooltip("Record what the receiver plays to a WAV file in your Documents folder");
+        captureButton.setClickingTogglesState(true);
+        captureButton.onClick = [this] { if (onCapture != nullptr) onCapture(captureButton.getToggleState()); };
+    }
+
+    std::function<void()> onDump;
+    std::function<void(bool shouldCapture)> onCapture;
+
+    void setCapturing(bool isCapturing)
+    {
+        captureButton.setToggleState(isCapturing, juce::dontSendNotification);
+    }
+
+    void setSnapshot(const TelemetryCollector::Snapshot& newSnapshot)
+    {
+        snapshot = newSnapshot;
+        repaint();
+    }
+
+    void setStatusText(const juce::String& text)
+    {
+        statusText = text;
+        repaint();
+    }
+
+    // Message-thread milliseconds per second the editor spends on its own updates and painting.
+    void setEditorLoad(double msPerSecond)
+    {
+        editorLoadMs = msPerSecond;
+
+        if (isVisible())
+            repaint();
+    }
+
+    void resized() override
+    {
+        auto header = getLocalBounds().removeFromTop(18);
+        dumpButton.setBounds(header.removeFromRight(50));
+        header.removeFromRight(4);
+        captureButton.setBounds(header.removeFromRight(60));
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto area = getLocalBounds().toFloat();
+        auto header = area.removeFromTop(18.0f);
+        header.removeFromRight(120.0f);
+
+        g.setFont(juce::Font(11.0f));
+        g.setColour(juce::Colours::lightgrey);
+        g.drawText(statusText.isNotEmpty() ? statusText
+                                           : "blocks " + juce::String((juce::int64) snapshot.blocks)
+                                             + "  underruns " + juce::String((juce::int64) snapshot.underruns)
+                                             + "  resyncs " + juce::String((juce::int64) snapshot.resyncs)
+                                             + "  concealed " + juce::String((juce::int64) snapshot.concealments)
+                                             + "  max " + juce::String(snapshot.maxLoad * 100.0, 1) + "%"
+                                             + "  ui " + juce::String(editorLoadMs, 2) + " ms/s",
+                   header, juce::Justification::centredLeft, true);
+
+        area.removeFromTop(4.0f);
+        const float columnWidth = area.getWidth() / 3.0f;
+
+        drawHistogram(g, area.removeFromLeft(columnWidth).reduced(3.0f, 0.0f), "time us", snapshot.processingMicros);
+        drawHistogram(g, area.removeFromLeft(columnWidth).reduced(3.0f, 0.0f), "fill", snapshot.fill);
+        drawHistogram(g, area.reduced(3.0f, 0.0f), "gap", snapshot.gap);
+    }
+
+private:
+    static void drawHistogram(juce::Graphics& g, juce::Rectangle<float> area, const char* title,
+                              const TelemetryCollector::Histogram& histogram)
+    {
+        using Histogram = TelemetryCollector::Histogram;
+
+        auto labelArea = area.removeFromBottom(14.0f);
+
+        g.setColour(juce::Colour::fromRGB(40, 40, 40));
+        g.fillRect(area);
+
+        // Only the occupied range of buckets, so a tight distribution still gets wide bars.
+        int first = Histogram::numBuckets, last = -1;
+        uint64_t largest = 0;
+
+        for (int bucket = 0; bucket < Histogram::numBuckets; ++bucket)
+        {
+            if (histogram.counts[bucket] == 0)
+                continue;
+
+            first = juce::jmin(first, bucket);
+            last = bucket;
+            largest = juce::jmax(largest, histogram.counts[bucket]);
+        }
+
+        g.setFont(juce::Font(10.0f));
+        g.setColour(juce::Colours::grey);
+
+        if (last < 0)
+        {
+            g.drawText(title, labelArea, juce::Justification::centred, false);
+            return;
+        }
+
+        const float barWidth = area.getWidth() / (float) (last - first + 1);
+
+        // Log scale on the counts too, so rare outliers are still visible next to the bulk.
+        const float logLargest = std::log1p((float) largest);
+
+        g.setColour(juce::Colours::goldenrod);
+
+        for (int bucket = first; bucket <= last; ++bucket)
+        {
+            const float height = area.getHeight() * std::log1p((float) histogram.counts[bucket]) / logLargest;
+            g.fillRect(juce::Rectangle<float>(area.getX() + barWidth * (float) (bucket - first), area.getBottom() - height,
+                                              barWidth, height).reduced(0.5f, 0.0f));
+        }
+
+        g.setColour(juce::Colours::grey);
+        g.drawText(juce::String((juce::int64) Histogram::lowerBound(first)), labelArea, juce::Justification::centredLeft, false);
+        g.drawText(title, labelArea, juce::Justification::centred, false);
+        g.drawText(juce::String((juce::int64) Histogram::lowerBound(last)), labelArea, juce::Justification::centredRight, false);
+    }
+
+    TelemetryCollector::Snapshot snapshot;
+    juce::String statusText;
+    double editorLoadMs = 0.0;
+    juce::TextButton dumpButton, captureButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryView)
+};
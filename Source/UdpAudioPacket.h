@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "SampleFormat.h"
+
+// Wire format for audio sent over UDP instead of shared memory (see UdpReceiver.h).
+//
+// One datagram carries a run of whole interleaved frames behind a fixed 40-byte header:
+//
+//     offset  size  field
+//          0     4  magic 'ARUP'
+//          4     2  version
+//          6     2  numChannels    samples per frame, dummies included
+//          8     4  sessionId      random per sender run; a new value means the sender restarted
+//         12     2  encoding       SampleFormat::Encoding of the payload
+//         14     2  numFrames
+//         16     8  sequence       +1 per datagram within a session
+//         24     8  firstFrame     sender frame index of the first frame in the payload
+//         32     8  sampleRate     IEEE double
+//         40        payload: numFrames * numChannels samples
+//
+// Multi-byte fields are little-endian, like the samples themselves (see SampleFormat.h). A sender
+// should keep datagrams within maxDatagramBytes so they never fragment on a standard Ethernet
+// path; the receiver accepts anything up to maxReceiveBytes.
+//
+// Standard library only, so the sender can share it.
+namespace UdpAudioPacket
+{
+    static constexpr uint32_t magic = 0x50555241;    // 'ARUP'
+    static constexpr uint16_t version = 1;
+    static constexpr size_t headerBytes = 40;
+    static constexpr size_t maxDatagramBytes = 1472; // 1500-byte MTU minus IPv4 and UDP headers
+    static constexpr size_t maxReceiveBytes = 9000;  // Jumbo frames
+    static constexpr int maxChannels = 32;
+
+    struct Header
+    {
+        uint16_t numChannels = 0;
+        uint32_t sessionId = 0;
+        SampleFormat::Encoding encoding = SampleFormat::float32;
+        uint16_t numFrames = 0;
+        uint64_t sequence = 0;
+        uint64_t firstFrame = 0;
+        double sampleRate = 0.0;
+    };
+
+    // The most frames of this shape that fit in one datagram of maxDatagramBytes.
+    inline int maxFramesPerDatagram (int numChannels, SampleFormat::Encoding encoding) noexcept
+    {
+        const size_t frameBytes = (size_t) numChannels * (size_t) SampleFormat::bytesPerSample (encoding);
+        return frameBytes > 0 ? (int) ((maxDatagramBytes - headerBytes) / frameBytes) : 0;
+    }
+
+    inline size_t payloadBytes (const Header& header) noexcept
+    {
+        return (size_t) header.numFrames * header.numChannels * (size_t) SampleFormat::bytesPerSample (header.encoding);
+    }
+
+    // Writes the header into the first headerBytes of `datagram`; the payload follows it.
+    inline void writeHeader (const Header& header, uint8_t* datagram) noexcept
+    {
+        const uint16_t encoding = (uint16_t) header.encoding;
+
+        std::memcpy (datagram + 0,  &magic, 4);
+        std::memcpy (datagram + 4,  &version, 2);
+        std::memcpy (datagram + 6,  &header.numChannels, 2);
+        std::memcpy (datagram + 8,  &header.sessionId, 4);
+        std::memcpy (datagram + 12, &encoding, 2);
+        std::memcpy (datagram + 14, &header.numFrames, 2);
+        std::memcpy (datagram + 16, &header.sequence, 8);
+        std::memcpy (datagram + 24, &header.firstFrame, 8);
+        std::memcpy (datagram + 32, &header.sampleRate, 8);
+    }
+
+    // Reads and checks a received datagram. Returns the payload, or null if the datagram isn't a
+    // well-formed packet of a version we understand.
+    inline const uint8_t* parse (const uint8_t* datagram, size_t size, Header& header) noexcept
+    {
+        if (size < headerBytes)
+            return nullptr;
+
+        uint32_t packetMagic = 0;
+        uint16_t packetVersion = 0, encoding = 0;
+
+        std::memcpy (&packetMagic, datagram + 0, 4);
+        std::memcpy (&packetVersion, datagram + 4, 2);
+        std::memcpy (&header.numChannels, datagram + 6, 2);
+        std::memcpy (&header.sessionId, datagram + 8, 4);
+        std::memcpy (&encoding, datagram + 12, 2);
+        std::memcpy (&header.numFrames, datagram + 14, 2);
+        std::memcpy (&header.sequence, datagram + 16, 8);
+        std::memcpy (&header.firstFrame, datagram + 24, 8);
+        std::memcpy (&header.sampleRate, datagram + 32, 8);
+
+        if (packetMagic != magic || packetVersion != version || encoding >= SampleFormat::numEncodings
+            || header.numChannels == 0 || header.numChannels > maxChannels || header.numFrames == 0
+            || ! (header.sampleRate > 0.0))
+            return nullptr;
+
+        header.encoding = (SampleFormat::Encoding) encoding;
+        return headerBytes + payloadBytes (header) <= size ? datagram + headerBytes : nullptr;
+    }
+}
@@ -0,0 +1,377 @@
+#include "UdpReceiver.h"
+#include "FrameWaiter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr int receiveBatch = 32;              // Datagrams per recvmmsg call
+    constexpr int receiveTimeoutMs = 100;         // How often the thread checks for stop() when idle
+    constexpr uint64_t idleAfterMs = 1000;        // No packets for this long: the sender counts as inactive
+
+    uint64_t nowMs()
+    {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+bool UdpReceiver::parseStreamName(const std::string& name, uint16_t& port)
+{
+    static const std::string prefix = "udp:";
+
+    if (name.compare(0, prefix.size(), prefix) != 0 || name.size() == prefix.size() || name.size() > prefix.size() + 5)
+        return false;
+
+    unsigned long value = 0;
+
+    for (size_t i = prefix.size(); i < name.size(); ++i)
+    {
+        if (name[i] < '0' || name[i] > '9')
+            return false;
+
+        value = value * 10 + (unsigned long) (name[i] - '0');
+    }
+
+    if (value == 0 || value > 65535)
+        return false;
+
+    port = (uint16_t) value;
+    return true;
+}
+
+UdpReceiver::~UdpReceiver()
+{
+    stop();
+}
+
+bool UdpReceiver::start(uint16_t port, uint64_t newRingFrames, std::string& error)
+{
+    stop();
+
+    if (newRingFrames < SegmentLayout::minRingFrames || newRingFrames > SegmentLayout::maxRingFrames
+        || (newRingFrames & (newRingFrames - 1)) != 0)
+    {
+        error = "bad ring size";
+        return false;
+    }
+
+    socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (socketFd == -1)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    // Room for a few hundred milliseconds of bursts while the thread is descheduled.
+    const int receiveBufferBytes = 1 << 20;
+    setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &receiveBufferBytes, sizeof(receiveBufferBytes));
+
+    timeval timeout { 0, receiveTimeoutMs * 1000 };
+    setsockopt(socketFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(socketFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        error = std::strerror(errno);
+        close(socketFd);
+        socketFd = -1;
+        return false;
+    }
+
+    boundPort = port;
+    ringFrames = newRingFrames;
+    shouldStop.store(false);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void UdpReceiver::stop()
+{
+    if (thread.joinable())
+    {
+        shouldStop.store(true);
+        shutdown(socketFd, SHUT_RDWR);   // Ends a blocked receive right away
+        thread.join();
+    }
+
+    if (socketFd != -1)
+    {
+        close(socketFd);
+        socketFd = -1;
+    }
+
+    releaseSegment();
+}
+
+std::string UdpReceiver::getSegmentName() const
+{
+    const std::lock_guard<std::mutex> lock(nameLock);
+    return segmentName;
+}
+
+void UdpReceiver::run()
+{
+    std::vector<uint8_t> buffers((size_t) receiveBatch * UdpAudioPacket::maxReceiveBytes);
+
+   #if defined (__linux__)
+    mmsghdr messages[receiveBatch] {};
+    iovec vectors[receiveBatch] {};
+
+    for (int i = 0; i < receiveBatch; ++i)
+    {
+        vectors[i].iov_base = buffers.data() + (size_t) i * UdpAudioPacket::maxReceiveBytes;
+        vectors[i].iov_len = UdpAudioPacket::maxReceiveBytes;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (!shouldStop.load(std::memory_order_relaxed))
+    {
+        // Blocks for the first datagram, then takes whatever else is already queued.
+        const int received = recvmmsg(socketFd, messages, receiveBatch, MSG_WAITFORONE, nullptr);
+
+        if (received <= 0)
+        {
+            noteIdle();
+            continue;
+        }
+
+        for (int i = 0; i < received; ++i)
+        {
+            if ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0)
+                stats.malformedPackets.fetch_add(1, std::memory_order_relaxed);
+            else
+                handleDatagram(static_cast<const uint8_t*>(vectors[i].iov_base), messages[i].msg_len);
+
+            messages[i].msg_hdr.msg_flags = 0;
+        }
+
+        publishWriteIndex();
+    }
+   #else
+    while (!shouldStop.load(std::memory_order_relaxed))
+    {
+        const ssize_t received = recv(socketFd, buffers.data(), UdpAudioPacket::maxReceiveBytes, 0);
+
+        if (received <= 0)
+        {
+            noteIdle();
+            continue;
+        }
+
+        handleDatagram(buffers.data(), (size_t) received);
+        publishWriteIndex();
+    }
+   #endif
+}
+
+void UdpReceiver::handleDatagram(const uint8_t* datagram, size_t size)
+{
+    UdpAudioPacket::Header packet;
+    const uint8_t* payload = UdpAudioPacket::parse(datagram, size, packet);
+
+    if (payload == nullptr)
+    {
+        stats.malformedPackets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    stats.packets.fetch_add(1, std::memory_order_relaxed);
+    lastPacketMs = nowMs();
+
+    if (header == nullptr || packet.numChannels != numChannels || packet.sampleRate != sampleRate)
+    {
+        // A different shape needs a different segment; the processor remaps when it sees the
+        // generation move.
+        if (!createSegment(packet))
+            return;
+
+        stats.restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (packet.sessionId != sessionId)
+    {
+        stats.restarts.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (packet.sequence < nextSequence)
+    {
+        stats.latePackets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    else if (packet.sequence > nextSequence)
+    {
+        stats.lostPackets.fetch_add(packet.sequence - nextSequence, std::memory_order_relaxed);
+
+        // Fill the hole unless it is so long that the reader has run dry and concealed it anyway.
+        const uint64_t missing = packet.firstFrame > nextFrame ? packet.firstFrame - nextFrame : 0;
+
+        if (missing > 0 && missing <= ringFrames / 4)
+            concealFrames(missing);
+    }
+
+    live.isActive->store(1, std::memory_order_relaxed);
+    sessionId = packet.sessionId;
+    nextSequence = packet.sequence + 1;
+    nextFrame = packet.firstFrame + packet.numFrames;
+
+    // Decode to floats, then split into channels for the concealer's fade-in and history.
+    const int frames = std::min((int) packet.numFrames, planarFrames);
+    SampleFormat::decode(packet.encoding, payload, interleaved.data(), frames * numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < frames; ++i)
+            planarChannels[(size_t) ch][i] = interleaved[(size_t) (i * numChannels + ch)];
+
+    concealer.played(planarChannels.data(), numChannels, frames);
+    writePlanar(frames);
+}
+
+void UdpReceiver::noteIdle()
+{
+    if (header != nullptr && nowMs() - lastPacketMs > idleAfterMs)
+        live.isActive->store(0, std::memory_order_release);
+}
+
+void UdpReceiver::concealFrames(uint64_t numFrames)
+{
+    stats.concealedFrames.fetch_add(numFrames, std::memory_order_relaxed);
+
+    while (numFrames > 0)
+    {
+        const int frames = (int) std::min(numFrames, (uint64_t) planarFrames);
+        concealer.conceal(planarChannels.data(), numChannels, 0, frames);
+        writePlanar(frames);
+        numFrames -= (uint64_t) frames;
+    }
+}
+
+void UdpReceiver::writePlanar(int numFrames)
+{
+    for (int i = 0; i < numFrames; ++i)
+    {
+        float* frame = ring + ((writeIndex + (uint64_t) i) & ringMask) * (uint64_t) numChannels;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            frame[ch] = planarChannels[(size_t) ch][i];
+    }
+
+    writeIndex += (uint64_t) numFrames;
+}
+
+void UdpReceiver::publishWriteIndex()
+{
+    if (header != nullptr)
+    {
+        live.writeIndex->store(writeIndex, std::memory_order_release);
+        FrameWaiter::wake(*live.writeIndex);
+    }
+}
+
+bool UdpReceiver::createSegment(const UdpAudioPacket::Header& shape)
+{
+    releaseSegment();
+
+    const uint32_t nextGeneration = generation.load() + 1;
+    const std::string name = "/ARudp" + std::to_string(boundPort) + "." + std::to_string((int) getpid())
+                             + "." + std::to_string(nextGeneration);
+
+    SegmentLayout::Header wanted;
+    SegmentLayout::describe(wanted, ringFrames, shape.numChannels, shape.sampleRate);
+
+    shm_unlink(name.c_str());   // A leftover from a crashed process with our pid
+    segmentFd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (segmentFd == -1 || ftruncate(segmentFd, (off_t) wanted.segmentBytes) == -1)
+    {
+        releaseSegment();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, (size_t) wanted.segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED, segmentFd, 0);
+
+    if (mapped == MAP_FAILED)
+    {
+        releaseSegment();
+        return false;
+    }
+
+    // The processor only looks once the generation moves, by which time the magic is in.
+    header = static_cast<SegmentLayout::Header*>(mapped);
+    SegmentLayout::describe(*header, ringFrames, shape.numChannels, shape.sampleRate);
+    SegmentLayout::publish(*header);
+    live = SegmentLayout::locate(*header);
+
+    ring = reinterpret_cast<float*>(static_cast<uint8_t*>(mapped) + header->headerBytes);
+    ringMask = ringFrames - 1;
+    numChannels = shape.numChannels;
+    sampleRate = shape.sampleRate;
+    writeIndex = 0;
+
+    // Scratch for the largest datagram of this shape (2-byte samples pack the most frames in).
+    planarFrames = (int) (UdpAudioPacket::maxReceiveBytes / (2 * (size_t) numChannels));
+    interleaved.assign((size_t) (planarFrames * numChannels), 0.0f);
+    planar.assign((size_t) (planarFrames * numChannels), 0.0f);
+    planarChannels.resize((size_t) numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        planarChannels[(size_t) ch] = planar.data() + (size_t) (ch * planarFrames);
+
+    concealer.prepare(sampleRate, numChannels);
+
+    {
+        const std::lock_guard<std::mutex> lock(nameLock);
+        segmentName = name;
+    }
+
+    generation.store(nextGeneration, std::memory_order_release);
+    return true;
+}
+
+void UdpReceiver::releaseSegment()
+{
+    std::string name;
+
+    {
+        const std::lock_guard<std::mutex> lock(nameLock);
+        name.swap(segmentName);
+    }
+
+    if (header != nullptr)
+    {
+        // A processor still mapping it sees the sender go inactive until it remaps.
+        live.isActive->store(0, std::memory_order_release);
+        munmap(header, (size_t) header->segmentBytes);
+        header = nullptr;
+        live = {};
+        ring = nullptr;
+    }
+
+    if (segmentFd != -1)
+    {
+        close(segmentFd);
+        segmentFd = -1;
+    }
+
+    if (!name.empty())
+    {
+        shm_unlink(name.c_str());
+        shm_unlink((name + "_rd").c_str());   // The reader table the processor created next to it
+    }
+
+    numChannels = 0;
+    sampleRate = 0.0;
+}
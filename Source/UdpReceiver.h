@@ -0,0 +1,106 @@
+#pragma once
+
+#include "SegmentHeader.h"
+#include "UdpAudioPacket.h"
+#include "UnderrunConcealer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Network transport: receives sequenced audio datagrams (see UdpAudioPacket.h) on a background
+// thread and writes them into a local self-describing segment (see SegmentHeader.h). The
+// processor connects to that segment like to any sender's, so processBlock, the jitter buffer,
+// drift compensation and concealment all work unchanged on audio from another machine.
+//
+// The thread takes datagrams in batches (recvmmsg on Linux, one recvfrom at a time elsewhere),
+// decodes compact encodings on arrival so the ring is always float32, and publishes writeIndex once
+// per batch.
+//
+// Sequence gaps are lost packets. Their frames are filled with an UnderrunConcealer fade of what
+// came before, and the next packet fades back in, so a lost datagram sounds like a short dropout
+// rather than a splice. A longer outage isn't filled: the ring simply stops growing, the processor
+// underruns and conceals on its side. Packets older than one already received are dropped.
+//
+// The segment is created when the first packet arrives and replaced when the sender's channel
+// count or sample rate changes; getGeneration() moves each time so the processor knows to remap.
+// Standard library and POSIX only, so the tools can share it.
+class UdpReceiver
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> packets { 0 };
+        std::atomic<uint64_t> lostPackets { 0 };       // Sequence gaps
+        std::atomic<uint64_t> concealedFrames { 0 };   // Frames filled in for lost packets
+        std::atomic<uint64_t> latePackets { 0 };       // Arrived after a later one; dropped
+        std::atomic<uint64_t> malformedPackets { 0 };
+        std::atomic<uint64_t> restarts { 0 };          // New sender sessions and shape changes
+    };
+
+    static constexpr uint64_t defaultRingFrames = uint64_t (1) << 15;
+
+    // True for stream names of the form "udp:<port>", which select this transport.
+    static bool parseStreamName (const std::string& name, uint16_t& port);
+
+    UdpReceiver() = default;
+    ~UdpReceiver();
+
+    // Binds to the port on all interfaces and starts the receive thread. On failure returns false
+    // with the reason in `error`.
+    bool start (uint16_t port, uint64_t ringFrames, std::string& error);
+    void stop();
+
+    bool isRunning() const noexcept             { return thread.joinable(); }
+    uint16_t getPort() const noexcept           { return boundPort; }
+
+    // Any thread. The segment holding the received audio, empty until the first packet arrives.
+    std::string getSegmentName() const;
+    uint32_t getGeneration() const noexcept     { return generation.load (std::memory_order_acquire); }
+
+    const Stats& getStats() const noexcept      { return stats; }
+
+private:
+    void run();
+    void handleDatagram (const uint8_t* datagram, size_t size);
+    void noteIdle();
+    bool createSegment (const UdpAudioPacket::Header& shape);
+    void releaseSegment();
+    void concealFrames (uint64_t numFrames);
+    void writePlanar (int numFrames);
+    void publishWriteIndex();
+
+    int socketFd = -1;
+    uint16_t boundPort = 0;
+    uint64_t ringFrames = defaultRingFrames;
+    std::thread thread;
+    std::atomic<bool> shouldStop { false };
+
+    Stats stats;
+    std::atomic<uint32_t> generation { 0 };
+    mutable std::mutex nameLock;
+    std::string segmentName;
+
+    // Receive thread only.
+    int segmentFd = -1;
+    SegmentLayout::Header* header = nullptr;
+    SegmentLayout::LiveFields live;
+    float* ring = nullptr;
+    uint64_t ringMask = 0;
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    uint64_t writeIndex = 0;
+
+    uint32_t sessionId = 0;
+    uint64_t nextSequence = 0;
+    uint64_t nextFrame = 0;
+    uint64_t lastPacketMs = 0;
+
+    UnderrunConcealer concealer;
+    std::vector<float> interleaved, planar;
+    std::vector<float*> planarChannels;
+    int planarFrames = 0;
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Hides underruns instead of cutting straight to silence.
+//
+// When the ring runs dry mid-block, the processor plays whatever frames it has and hands the rest
+// of the block to conceal(). That repeats the last pitch period of the output (the lag whose
+// repetition best continues the final few samples, searched once per event) under a raised-cosine
+// fade to silence, then plays silence until data is back. The first block played after that fades
+// in over a shorter ramp. A dropout of a few samples becomes a brief fade instead of a hard click.
+//
+// Every played block's tail goes into a small circular history per channel. Storage is sized in
+// prepare(); played() and conceal() never allocate and run in time bounded by the block size and
+// the lag search range.
+class UnderrunConcealer
+{
+public:
+    static constexpr int maxChannels = 32;
+
+    // Message thread (or before playback starts).
+    void prepare (double sampleRate, int numChannels)
+    {
+        channels = std::clamp (numChannels, 1, maxChannels);
+
+        const double rate = sampleRate > 0.0 ? sampleRate : 48000.0;
+        minLag = std::max (8, (int) (rate * minLagSeconds));
+        maxLag = std::max (minLag + 1, (int) (rate * maxLagSeconds));
+
+        historySize = 1;
+        while (historySize < maxLag + matchFrames)
+            historySize <<= 1;
+
+        history.assign ((size_t) (channels * historySize), 0.0f);
+
+        fadeOut.resize ((size_t) std::max (1, (int) (rate * fadeOutSeconds)));
+        fadeIn.resize ((size_t) std::max (1, (int) (rate * fadeInSeconds)));
+
+        // Raised cosine from 1 down to 0 (exclusive at both ends, so neither ramp steps).
+        for (size_t i = 0; i < fadeOut.size(); ++i)
+            fadeOut[i] = 0.5f * (1.0f + (float) std::cos (3.14159265358979 * (double) (i + 1) / (double) (fadeOut.size() + 1)));
+
+        for (size_t i = 0; i < fadeIn.size(); ++i)
+            fadeIn[i] = 0.5f * (1.0f - (float) std::cos (3.14159265358979 * (double) (i + 1) / (double) (fadeIn.size() + 1)));
+
+        reset();
+    }
+
+    // Audio thread: forget everything, e.g. when playback restarts. Until something is played
+    // again there is nothing to conceal, so dropouts aren't counted as events.
+    void reset() noexcept
+    {
+        std::fill (history.begin(), history.end(), 0.0f);
+        historyPosition = 0;
+        historyValid = false;
+        concealing = false;
+        concealedFrames = 0;
+    }
+
+    bool isConcealing() const noexcept    { return concealing; }
+
+    // Audio thread: frames [0, numFrames) of `audio` came out of the ring. Fades them in if a
+    // concealment just ended (crossfading with its fade-out if that hasn't finished), then
+    // remembers the tail. Returns true if it faded in.
+    bool played (float* const* audio, int numChannels, int numFrames) noexcept
+    {
+        numChannels = std::min (numChannels, channels);
+        bool fadedIn = false;
+
+        if (concealing)
+        {
+            const int ramp = std::min (numFrames, (int) fadeIn.size());
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < ramp; ++i)
+                    audio[ch][i] = audio[ch][i] * fadeIn[(size_t) i] + repeated (ch, concealedFrames + i);
+
+            concealing = false;
+            fadedIn = true;
+        }
+
+        remember (audio, numChannels, 0, numFrames);
+        return fadedIn;
+    }
+
+    // Audio thread: frames [start, start + numFrames) have no data. Frames before `start` (if any)
+    // were just played from the ring and are taken into account first. Continues a running
+    // concealment or starts one; returns true if this started a new event.
+    bool conceal (float* const* audio, int numChannels, int start, int numFrames) noexcept
+    {
+        for (int ch = channels; ch < numChannels; ++ch)
+            std::memset (audio[ch] + start, 0, sizeof (float) * (size_t) numFrames);
+
+        numChannels = std::min (numChannels, channels);
+
+        if (start > 0)
+            remember (audio, numChannels, 0, start);
+
+        const bool startsEvent = ! concealing && historyValid;
+
+        if (! concealing)
+        {
+            concealing = true;
+            concealedFrames = 0;
+            lag = historyValid ? findLag (numChannels) : maxLag;
+            repeatFrom = historyPosition - lag;
+        }
+
+        // Past the end of the fade there is only silence.
+        const int faded = std::clamp ((int) fadeOut.size() - concealedFrames, 0, numFrames);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* d = audio[ch] + start;
+
+            for (int i = 0; i < faded; ++i)
+                d[i] = repeated (ch, concealedFrames + i);
+
+            std::memset (d + faded, 0, sizeof (float) * (size_t) (numFrames - faded));
+        }
+
+        concealedFrames = std::min (concealedFrames + numFrames, (int) fadeOut.size());
+        return startsEvent;
+    }
+
+private:
+    static constexpr double minLagSeconds = 0.0025;   // 400 Hz and up repeat several periods
+    static constexpr double maxLagSeconds = 0.0125;   // Down to 80 Hz
+    static constexpr double fadeOutSeconds = 0.010;
+    static constexpr double fadeInSeconds = 0.003;
+    static constexpr int matchFrames = 16;            // Samples compared when choosing the lag
+    static constexpr int searchChannels = 4;          // Channels the lag search looks at
+
+    // Frame n of the current concealment: the repeated period under the fade-out, 0 after it.
+    float repeated (int ch, int n) const noexcept
+    {
+        if (n >= (int) fadeOut.size())
+            return 0.0f;
+
+        return history[(size_t) (ch * historySize + ((repeatFrom + n % lag) & (historySize - 1)))] * fadeOut[(size_t) n];
+    }
+
+    void remember (const float* const* audio, int numChannels, int start, int numFrames) noexcept
+    {
+        // Only the last historySize frames can matter.
+        const int skip = std::max (0, numFrames - historySize);
+        const int mask = historySize - 1;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* h = history.data() + (size_t) (ch * historySize);
+            const float* s = audio[ch] + start;
+
+            for (int i = skip; i < numFrames; ++i)
+                h[(historyPosition + i - skip) & mask] = s[i];
+        }
+
+        historyPosition = (historyPosition + numFrames - skip) & mask;
+        historyValid = historyValid || numFrames > 0;
+    }
+
+    // The lag L (minLag..maxLag) for which the matchFrames samples ending L frames ago look most
+    // like the last matchFrames samples, so repeating from L frames back continues the waveform.
+    int findLag (int numChannels) const noexcept
+    {
+        const int mask = historySize - 1;
+        const int searched = std::min (numChannels, searchChannels);
+        int bestLag = maxLag;
+        float bestError = -1.0f;
+
+        for (int candidate = minLag; candidate <= maxLag; ++candidate)
+        {
+            float error = 0.0f;
+
+            for (int ch = 0; ch < searched; ++ch)
+            {
+                const float* h = history.data() + (size_t) (ch * historySize);
+
+                for (int i = 1; i <= matchFrames; ++i)
+                {
+                    const float diff = h[(historyPosition - i) & mask] - h[(historyPosition - i - candidate) & mask];
+                    error += diff * diff;
+                }
+            }
+
+            if (bestError < 0.0f || error < bestError)
+            {
+                bestError = error;
+                bestLag = candidate;
+            }
+        }
+
+        return bestLag;
+    }
+
+    int channels = 0;
+    int minLag = 120, maxLag = 600;
+    int historySize = 0;
+    int historyPosition = 0;
+    bool historyValid = false;
+
+    bool concealing = false;
+    int concealedFrames = 0;    // Into the current event, capped at the fade length
+    int lag = 0;
+    int repeatFrom = 0;
+
+    std::vector<float> history;
+    std::vector<float> fadeOut, fadeIn;
+};
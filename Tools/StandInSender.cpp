@@ -0,0 +1,90 @@
+// Command-line stand-in for the AudioSender plugin; see StandInSender.h.
+//
+// Usage: StandInSender [--name /Stream] [--label text] [--rate 48000] [--block 256]
+//                      [--jitter none|uniform:<ms>|burst:<n>|stall:<every ms>:<for ms>]
+//                      [--drift <ppm>] [--format float|int16|int24|fp16] [--ring <frames> [--layout 1|2]]
+//                      [--seconds <n>] [--timecode] [--keep] [--udp host:port [--drop-every <n>]] [--bpm <tempo>]
+// Runs until --seconds pass or Ctrl-C. --keep leaves the segment in place on exit. --ring writes a
+// self-describing segment with a ring of that many frames instead of the legacy layout, in the
+// current layout version unless --layout asks for another (see SegmentHeader.h). --udp sends
+// datagrams to a receiver listening on "udp:<port>" instead, dropping every n-th with --drop-every.
+// --bpm adds a transport position at that tempo to the time anchors of a version 2 segment.
+
+#include "StandInSender.h"
+
+#include <csignal>
+
+namespace
+{
+    std::atomic<bool> keepRunning { true };
+
+    void handleSignal (int)
+    {
+        keepRunning.store (false);
+    }
+
+    void printUsage()
+    {
+        std::fprintf (stderr, "Usage: StandInSender [--name /Stream] [--label text] [--rate 48000] [--block 256]\n"
+                              "                     [--jitter none|uniform:<ms>|burst:<n>|stall:<every ms>:<for ms>]\n"
+                              "                     [--drift <ppm>] [--format float|int16|int24|fp16] [--ring <frames> [--layout 1|2]]\n"
+                              "                     [--seconds <n>] [--timecode] [--keep] [--udp host:port [--drop-every <n>]] [--bpm <tempo>]\n");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    StandInSender::Options options;
+    double seconds = 0.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--name" && hasValue)            options.name = StreamDirectory::sanitiseName (argv[++i]);
+        else if (arg == "--label" && hasValue)      options.label = argv[++i];
+        else if (arg == "--rate" && hasValue)       options.sampleRate = std::atof (argv[++i]);
+        else if (arg == "--block" && hasValue)      options.blockSize = std::atoi (argv[++i]);
+        else if (arg == "--jitter" && hasValue)     options.jitter = argv[++i];
+        else if (arg == "--drift" && hasValue)      options.driftPpm = std::atof (argv[++i]);
+        else if (arg == "--format" && hasValue)     options.format = argv[++i];
+        else if (arg == "--ring" && hasValue)       options.ringFrames = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--layout" && hasValue)     options.layoutVersion = (uint32_t) std::atoi (argv[++i]);
+        else if (arg == "--seconds" && hasValue)    seconds = std::atof (argv[++i]);
+        else if (arg == "--timecode")               options.timecode = true;
+        else if (arg == "--keep")                   options.unlinkOnClose = false;
+        else if (arg == "--udp" && hasValue)        options.udpTarget = argv[++i];
+        else if (arg == "--drop-every" && hasValue) options.dropEvery = std::atoi (argv[++i]);
+        else if (arg == "--bpm" && hasValue)        options.bpm = std::atof (argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (options.name.empty() || options.sampleRate <= 0.0 || options.blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::signal (SIGINT, handleSignal);
+    std::signal (SIGTERM, handleSignal);
+
+    options.verbose = true;
+    StandInSender sender (options);
+
+    if (! sender.open())
+        return 1;
+
+    std::printf ("Sending on %s: %.0f Hz, %d-frame blocks, jitter %s, drift %+.1f ppm\n",
+                 options.udpTarget.empty() ? options.name.c_str() : ("udp " + options.udpTarget).c_str(), options.sampleRate, options.blockSize, options.jitter.c_str(), options.driftPpm);
+
+    sender.run (keepRunning, seconds);
+
+    std::printf ("Wrote %llu frames\n", (unsigned long long) sender.getWriteIndex());
+    sender.close();
+    return 0;
+}
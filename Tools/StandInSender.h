@@ -0,0 +1,676 @@
+#pragma once
+
+#include "SharedMemoryManager.h"
+#include "StreamDirectory.h"
+#include "ReaderRegistry.h"
+#include "SegmentHeader.h"
+#include "FrameWaiter.h"
+#include "UdpAudioPacket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <netdb.h>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// A headless stand-in for the AudioSender plugin.
+//
+// Creates the segment described by SharedMemoryManager.h (or, given a ring size, a self-describing
+// one, see SegmentHeader.h), announces it in the stream directory and writes 10-channel
+// interleaved frames (the first two channels are dummies, as in the real
+// sender) at a given rate and block size. Delivery can be disturbed by a jitter pattern so the
+// receiver's buffering and drift handling can be exercised without a DAW:
+//     none                  every block on time
+//     uniform:<ms>          each block late by a random 0..ms (the clock itself doesn't move)
+//     burst:<n>             n blocks at once, every n block periods
+//     stall:<every>:<for>   every <every> ms, stop writing for <for> ms, then catch up
+// With timecode enabled, the first audio channel carries the frame index (mod 2^24, exact in a
+// float) instead of a tone, and the write time of every block is kept so a harness can measure
+// end-to-end latency with getWriteTimeNs().
+//
+// Frames are written as floats unless a compact encoding is asked for (see SampleFormat.h). The
+// requested encoding is only used while every live reader in the stream's reader table can decode
+// it; the sender re-checks with each heartbeat and falls back to float32 (at the current frame)
+// when a reader that can't joins. Timecode needs float32. A self-describing segment carries the
+// encoding in its own header rather than in the reader table.
+//
+// A version 2 segment also gets a time anchor with every block: its first frame and the time it
+// was due on the sender's schedule (not when it went out, so jitter doesn't move the timeline).
+// Given a tempo, the anchors carry a transport position too, as if playing from the first frame.
+//
+// Given a UDP target instead, the same frames go out as datagrams (see UdpAudioPacket.h) in the
+// requested encoding, with no segment or directory entry; every n-th datagram can be dropped to
+// simulate loss.
+//
+// Used by the StandInSender tool and the processBlock benchmark; standard library and POSIX only.
+class StandInSender
+{
+public:
+    struct Options
+    {
+        std::string name { SHARED_MEMORY_NAME };
+        std::string label { "Stand-in sender" };
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double driftPpm = 0.0;        // Positive: run fast against the steady clock
+        std::string jitter { "none" };
+        bool timecode = false;
+        bool unlinkOnClose = true;
+        std::string format { "float" };   // float, int16, int24 or fp16
+        uint64_t ringFrames = 0;          // 0: legacy SharedAudioData; otherwise a self-describing ring this long
+        uint32_t layoutVersion = SegmentLayout::version;   // Of the self-describing segment (see SegmentHeader.h)
+        std::string udpTarget;            // "host:port": send datagrams there instead of writing shared memory
+        int dropEvery = 0;                // UDP: skip every n-th datagram (0: none)
+        double bpm = 0.0;                 // Above 0: anchors carry a transport position at this tempo
+        bool verbose = false;             // Print encoding switches to stdout (the tool, not the checks)
+    };
+
+    static constexpr int totalChannels = 10;
+    static constexpr int dummyChannels = 2;
+
+    explicit StandInSender (Options o) : options (std::move (o)) {}
+    ~StandInSender() { close(); }
+
+    bool open()
+    {
+        if (! parseJitter())
+        {
+            std::fprintf (stderr, "Unknown jitter pattern '%s'\n", options.jitter.c_str());
+            return false;
+        }
+
+        if (! SampleFormat::fromName (options.format, preferredEncoding))
+        {
+            std::fprintf (stderr, "Unknown sample format '%s'\n", options.format.c_str());
+            return false;
+        }
+
+        if (options.timecode && preferredEncoding != SampleFormat::float32)
+        {
+            std::fprintf (stderr, "Timecode needs the float format\n");
+            return false;
+        }
+
+        if (! options.udpTarget.empty())
+            return openUdp();
+
+        if (! (options.ringFrames == 0 ? openLegacySegment() : openSelfDescribingSegment()))
+            return false;
+
+        writeIndex = firstFrame = loadWriteIndex();
+
+        // The encoding goes out before the first frame; without a reader table only float32 is safe.
+        openReaderTable();
+        negotiateEncoding (true);
+
+        setActive (true);
+
+        // Segment first, then the announcement, so a woken receiver finds it ready.
+        directory.publish (options.name, options.label, totalChannels - dummyChannels);
+        return true;
+    }
+
+    void close()
+    {
+        directory.withdraw();
+
+        if (udpSocket != -1)
+        {
+            ::close (udpSocket);
+            udpSocket = -1;
+        }
+
+        // Hand the next sender a clean slate: float32 from the start, as older senders expect.
+        if (readerTable != nullptr)
+            ReaderTableLayout::storeRingFormat (*readerTable, SampleFormat::float32, 0);
+
+        if (readerTableFd != -1)
+        {
+            ::close (readerTableFd);
+            readerTableFd = -1;
+        }
+
+        if (segment != nullptr)
+        {
+            setActive (false);
+            munmap (segment, segmentBytes);
+            segment = nullptr;
+            data = nullptr;
+            header = nullptr;
+            live = {};
+        }
+
+        if (fd != -1)
+        {
+            ::close (fd);
+            fd = -1;
+
+            if (options.unlinkOnClose)
+                shm_unlink (options.name.c_str());
+        }
+
+        if (readerTable != nullptr)
+        {
+            // Checked after our segment is unlinked: a reader that detaches before this sees our
+            // segment and leaves the table to us, one that detaches after it removes it itself.
+            if (options.unlinkOnClose && readerTable->activeMask.load (std::memory_order_acquire) == 0)
+                shm_unlink ((options.name + "_rd").c_str());
+
+            munmap (readerTable, sizeof (ReaderTableLayout::Table));
+            readerTable = nullptr;
+        }
+    }
+
+    // Writes blocks on schedule until `keepRunning` goes false or `seconds` pass (<= 0: forever).
+    void run (const std::atomic<bool>& keepRunning, double seconds)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const double period = (double) options.blockSize / options.sampleRate / (1.0 + options.driftPpm * 1.0e-6);
+        const auto start = Clock::now();
+        const int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds> (start.time_since_epoch()).count();
+        auto lastHeartbeat = start;
+        uint64_t blocksWritten = 0;
+
+        while (keepRunning.load())
+        {
+            const double elapsed = std::chrono::duration<double> (Clock::now() - start).count();
+
+            if (seconds > 0.0 && elapsed >= seconds)
+                break;
+
+            // Every block that is due (per the jitter pattern) goes out now; otherwise sleep a bit.
+            const uint64_t due = (uint64_t) std::max (0.0, std::floor ((elapsed - jitterDelay (blocksWritten, period)) / period) + 1.0);
+
+            if (blocksWritten < due && releaseAllowed (elapsed))
+            {
+                writeBlock (startNs + (int64_t) std::llround ((double) blocksWritten * period * 1.0e9));
+                ++blocksWritten;
+                continue;
+            }
+
+            if (udpSocket == -1 && Clock::now() - lastHeartbeat > std::chrono::milliseconds (500))
+            {
+                directory.heartbeat();
+                negotiateEncoding (false);
+                lastHeartbeat = Clock::now();
+            }
+
+            std::this_thread::sleep_for (std::chrono::microseconds (200));
+        }
+    }
+
+    // Writes one block immediately. dueNs is the steady-clock time its first frame belongs to.
+    void writeBlock (int64_t dueNs = nowNs())
+    {
+        const uint64_t mask = ringMask;
+        const size_t frameBytes = (size_t) totalChannels * (size_t) SampleFormat::bytesPerSample (encoding);
+
+        if (udpSocket != -1)
+        {
+            sendBlock();
+            return;
+        }
+
+        for (int i = 0; i < options.blockSize; ++i)
+        {
+            const uint64_t frame = writeIndex + (uint64_t) i;
+            float out[totalChannels];
+
+            renderFrame (frame, out);
+            SampleFormat::encode (encoding, out, samples + (size_t) (frame & mask) * frameBytes, totalChannels);
+        }
+
+        writeTimes[blockSlot (writeIndex)].store (nowNs(), std::memory_order_relaxed);
+
+        if (live.anchor != nullptr)
+        {
+            SegmentLayout::Anchor anchor;
+            anchor.frame = writeIndex;
+            anchor.clockNs = dueNs;
+            anchor.ppq = options.bpm > 0.0 ? (double) (writeIndex - firstFrame) / options.sampleRate * options.bpm / 60.0
+                                           : std::numeric_limits<double>::quiet_NaN();
+            SegmentLayout::publishAnchor (*live.anchor, anchor);
+        }
+
+        writeIndex += (uint64_t) options.blockSize;
+        if (header != nullptr)
+        {
+            live.writeIndex->store (writeIndex, std::memory_order_release);
+            FrameWaiter::wake (*live.writeIndex);   // A receiver bouncing offline may be waiting for it
+        }
+        else
+        {
+            data->writeIndex.store (writeIndex, std::memory_order_release);
+        }
+    }
+
+    // Steady-clock time at which the block containing `frame` was written, or -1 if that block is
+    // too old to still be recorded. Safe to call from another thread while run() is going.
+    int64_t getWriteTimeNs (uint64_t frame) const noexcept
+    {
+        const uint64_t written = loadWriteIndex();
+
+        if (frame < firstFrame || frame >= written || written - frame > (uint64_t) options.blockSize * (writeTimeSlots - 2))
+            return -1;
+
+        return writeTimes[blockSlot (frame)].load (std::memory_order_relaxed);
+    }
+
+    // Recovers the full frame index from a timecode sample, given a recent frame for the high bits.
+    static uint64_t decodeTimecode (float sample, uint64_t nearFrame) noexcept
+    {
+        const uint64_t low = (uint64_t) std::llround (sample) & timecodeMask;
+        uint64_t frame = (nearFrame & ~timecodeMask) | low;
+
+        if (frame > nearFrame)
+            frame -= timecodeMask + 1;
+
+        return frame;
+    }
+
+    uint64_t getWriteIndex() const noexcept   { return loadWriteIndex(); }
+
+    SampleFormat::Encoding getEncoding() const noexcept   { return encoding; }
+
+    // UDP: datagrams sent, and those skipped on purpose (dropEvery).
+    uint64_t getDatagramsSent() const noexcept      { return datagramsSent; }
+    uint64_t getDatagramsDropped() const noexcept   { return datagramsDropped; }
+
+    static int64_t nowNs() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    void renderFrame (uint64_t frame, float* out) const
+    {
+        out[0] = out[1] = 0.0f;
+
+        for (int ch = dummyChannels; ch < totalChannels; ++ch)
+        {
+            // A different tone per channel so routing mistakes are audible.
+            const double hz = 220.0 * (double) (ch - dummyChannels + 1);
+            out[ch] = 0.25f * (float) std::sin (2.0 * 3.14159265358979 * hz * (double) frame / options.sampleRate);
+        }
+
+        if (options.timecode)
+            out[dummyChannels] = (float) (frame & timecodeMask);
+    }
+
+    bool openUdp()
+    {
+        const auto colon = options.udpTarget.rfind (':');
+
+        if (colon == std::string::npos)
+        {
+            std::fprintf (stderr, "UDP target must be host:port\n");
+            return false;
+        }
+
+        const std::string host = options.udpTarget.substr (0, colon);
+        const std::string port = options.udpTarget.substr (colon + 1);
+
+        addrinfo hints {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* found = nullptr;
+
+        if (getaddrinfo (host.c_str(), port.c_str(), &hints, &found) != 0 || found == nullptr)
+        {
+            std::fprintf (stderr, "Can't resolve %s\n", options.udpTarget.c_str());
+            return false;
+        }
+
+        udpSocket = socket (found->ai_family, found->ai_socktype, found->ai_protocol);
+        const bool connected = udpSocket != -1 && connect (udpSocket, found->ai_addr, found->ai_addrlen) == 0;
+        freeaddrinfo (found);
+
+        if (! connected)
+        {
+            std::perror ("socket/connect");
+            return false;
+        }
+
+        // The receiver decodes every encoding, so no negotiation: send what was asked for.
+        encoding = preferredEncoding;
+        sessionId = std::random_device() () | 1u;
+        writeIndex = firstFrame = 0;
+        return true;
+    }
+
+    // Renders one block and sends it as whole-frame datagrams that fit an Ethernet MTU.
+    void sendBlock()
+    {
+        const int framesPerDatagram = UdpAudioPacket::maxFramesPerDatagram (totalChannels, encoding);
+        const size_t frameBytes = (size_t) totalChannels * (size_t) SampleFormat::bytesPerSample (encoding);
+        uint8_t datagram[UdpAudioPacket::maxDatagramBytes];
+
+        for (int start = 0; start < options.blockSize; start += framesPerDatagram)
+        {
+            UdpAudioPacket::Header packet;
+            packet.numChannels = (uint16_t) totalChannels;
+            packet.sessionId = sessionId;
+            packet.encoding = encoding;
+            packet.numFrames = (uint16_t) std::min (framesPerDatagram, options.blockSize - start);
+            packet.sequence = sequence++;
+            packet.firstFrame = writeIndex + (uint64_t) start;
+            packet.sampleRate = options.sampleRate;
+
+            for (int i = 0; i < packet.numFrames; ++i)
+            {
+                float out[totalChannels];
+                renderFrame (packet.firstFrame + (uint64_t) i, out);
+                SampleFormat::encode (encoding, out, datagram + UdpAudioPacket::headerBytes + (size_t) i * frameBytes, totalChannels);
+            }
+
+            if (options.dropEvery > 0 && packet.sequence % (uint64_t) options.dropEvery == (uint64_t) options.dropEvery - 1)
+            {
+                ++datagramsDropped;
+                continue;
+            }
+
+            UdpAudioPacket::writeHeader (packet, datagram);
+
+            if (send (udpSocket, datagram, UdpAudioPacket::headerBytes + UdpAudioPacket::payloadBytes (packet), 0) > 0)
+                ++datagramsSent;
+        }
+
+        writeTimes[blockSlot (writeIndex)].store (nowNs(), std::memory_order_relaxed);
+        writeIndex += (uint64_t) options.blockSize;
+        framesSent.store (writeIndex, std::memory_order_release);
+    }
+
+    bool openLegacySegment()
+    {
+        fd = shm_open (options.name.c_str(), O_CREAT | O_RDWR, 0666);
+
+        if (fd == -1 || ftruncate (fd, (off_t) MAX_BUFFER_SIZE) == -1)
+        {
+            std::perror ("shm_open/ftruncate");
+            return false;
+        }
+
+        if (! mapSegment (MAX_BUFFER_SIZE))
+            return false;
+
+        data = static_cast<SharedAudioData*> (segment);
+        samples = reinterpret_cast<uint8_t*> (data->audioData);
+        ringMask = SharedAudioData::BUFFER_MASK;
+        return true;
+    }
+
+    // Picks up a segment left by an earlier run if it has exactly the shape we want (so receivers
+    // that still have it mapped carry on), otherwise replaces it. Never resizes one in place: a
+    // receiver with the old size mapped would fault on the part that went away.
+    bool openSelfDescribingSegment()
+    {
+        const uint64_t frames = options.ringFrames;
+
+        if (frames < SegmentLayout::minRingFrames || frames > SegmentLayout::maxRingFrames || (frames & (frames - 1)) != 0)
+        {
+            std::fprintf (stderr, "Ring size must be a power of two from %llu to %llu frames\n",
+                          (unsigned long long) SegmentLayout::minRingFrames, (unsigned long long) SegmentLayout::maxRingFrames);
+            return false;
+        }
+
+        if (options.layoutVersion < SegmentLayout::oldestVersion || options.layoutVersion > SegmentLayout::version)
+        {
+            std::fprintf (stderr, "Layout version must be %u to %u\n", SegmentLayout::oldestVersion, SegmentLayout::version);
+            return false;
+        }
+
+        SegmentLayout::Header wanted;
+        SegmentLayout::describe (wanted, frames, (uint32_t) totalChannels, options.sampleRate, options.layoutVersion);
+
+        // Keep clear of the sizes a receiver takes for a legacy segment before our magic is in.
+        const uint64_t pageSize = (uint64_t) sysconf (_SC_PAGESIZE);
+        uint64_t fileBytes = wanted.segmentBytes;
+
+        if (fileBytes >= MAX_BUFFER_SIZE && fileBytes < MAX_BUFFER_SIZE + pageSize)
+            fileBytes = MAX_BUFFER_SIZE + 2 * pageSize;
+
+        segmentBytes = (size_t) wanted.segmentBytes;
+        fd = shm_open (options.name.c_str(), O_RDWR, 0666);
+
+        if (fd != -1)
+        {
+            struct stat info {};
+            const auto* existing = fstat (fd, &info) == 0 && (uint64_t) info.st_size == fileBytes && mapSegment (segmentBytes)
+                                       ? static_cast<const SegmentLayout::Header*> (segment) : nullptr;
+
+            if (existing != nullptr && existing->segmentMagic.load (std::memory_order_acquire) == SegmentLayout::magic
+                && existing->layoutVersion == wanted.layoutVersion && existing->numChannels == wanted.numChannels
+                && existing->ringFrames == wanted.ringFrames && existing->sampleAreaBytes == wanted.sampleAreaBytes
+                && existing->segmentBytes == wanted.segmentBytes && existing->sampleRate == wanted.sampleRate)
+            {
+                useHeader();
+                return true;
+            }
+
+            if (segment != nullptr)
+                munmap (segment, segmentBytes);
+
+            segment = nullptr;
+            ::close (fd);
+            shm_unlink (options.name.c_str());
+        }
+
+        fd = shm_open (options.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+
+        if (fd == -1 || ftruncate (fd, (off_t) fileBytes) == -1)
+        {
+            std::perror ("shm_open/ftruncate");
+            return false;
+        }
+
+        if (! mapSegment (segmentBytes))
+            return false;
+
+        // A fresh segment is all zeroes, which is every live field's starting value.
+        auto* fresh = static_cast<SegmentLayout::Header*> (segment);
+        SegmentLayout::describe (*fresh, frames, (uint32_t) totalChannels, options.sampleRate, options.layoutVersion);
+        SegmentLayout::publish (*fresh);
+        useHeader();
+        return true;
+    }
+
+    bool mapSegment (size_t bytes)
+    {
+        void* mapped = mmap (nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (mapped == MAP_FAILED)
+        {
+            std::perror ("mmap");
+            return false;
+        }
+
+        segment = mapped;
+        segmentBytes = bytes;
+        return true;
+    }
+
+    void useHeader()
+    {
+        header = static_cast<SegmentLayout::Header*> (segment);
+        live = SegmentLayout::locate (*header);
+        samples = static_cast<uint8_t*> (segment) + header->headerBytes;
+        ringMask = options.ringFrames - 1;
+    }
+
+    uint64_t loadWriteIndex() const noexcept
+    {
+        if (udpSocket != -1)
+            return framesSent.load (std::memory_order_acquire);
+
+        if (header != nullptr)
+            return live.writeIndex->load (std::memory_order_acquire);
+
+        return data != nullptr ? (uint64_t) data->writeIndex.load (std::memory_order_acquire) : 0;
+    }
+
+    void setActive (bool shouldBeActive)
+    {
+        if (header != nullptr)
+            live.isActive->store (shouldBeActive ? 1 : 0, std::memory_order_release);
+        else if (data != nullptr)
+            data->isActive.store (shouldBeActive);
+    }
+
+    // Maps "<name>_rd" the way ReaderRegistry does; any side may create it. No slot is claimed.
+    void openReaderTable()
+    {
+        const std::string tableName = options.name + "_rd";
+        readerTableFd = shm_open (tableName.c_str(), O_CREAT | O_RDWR, 0666);
+
+        struct stat info {};
+
+        if (readerTableFd == -1 || fstat (readerTableFd, &info) == -1
+            || ((size_t) info.st_size < sizeof (ReaderTableLayout::Table)
+                && ftruncate (readerTableFd, (off_t) sizeof (ReaderTableLayout::Table)) == -1))
+            return;
+
+        void* mapped = mmap (nullptr, sizeof (ReaderTableLayout::Table), PROT_READ | PROT_WRITE, MAP_SHARED, readerTableFd, 0);
+
+        if (mapped != MAP_FAILED)
+            readerTable = static_cast<ReaderTableLayout::Table*> (mapped);
+    }
+
+    // Switches to the preferred encoding while every live reader supports it, float32 otherwise.
+    // A switch takes effect at the next frame we write.
+    void negotiateEncoding (bool force)
+    {
+        auto wanted = SampleFormat::float32;
+
+        if (readerTable != nullptr)
+        {
+            const uint32_t common = ReaderTableLayout::commonEncodings (*readerTable, ReaderTableLayout::nowMs());
+            wanted = (common & SampleFormat::maskOf (preferredEncoding)) != 0 ? preferredEncoding : SampleFormat::float32;
+        }
+        else if (header == nullptr)
+        {
+            encoding = SampleFormat::float32;
+            return;
+        }
+
+        if (wanted == encoding && ! force)
+            return;
+
+        encoding = wanted;
+
+        if (header != nullptr)
+            live.ringFormat->store (ReaderTableLayout::packRingFormat (encoding, writeIndex), std::memory_order_release);
+        else
+            ReaderTableLayout::storeRingFormat (*readerTable, encoding, writeIndex);
+
+        if (options.verbose)
+            std::printf ("Writing %s from frame %llu\n", SampleFormat::getName (encoding), (unsigned long long) writeIndex);
+    }
+
+    size_t blockSlot (uint64_t frame) const noexcept
+    {
+        return (size_t) (((frame - firstFrame) / (uint64_t) options.blockSize) % writeTimeSlots);
+    }
+
+    bool parseJitter()
+    {
+        const auto& j = options.jitter;
+
+        if (j == "none")
+            return true;
+
+        if (std::sscanf (j.c_str(), "uniform:%lf", &jitterMs) == 1)    { pattern = Pattern::uniform; return true; }
+        if (std::sscanf (j.c_str(), "burst:%d", &burstBlocks) == 1)    { pattern = Pattern::burst; return burstBlocks > 0; }
+        if (std::sscanf (j.c_str(), "stall:%lf:%lf", &stallEveryMs, &stallForMs) == 2)
+        {
+            pattern = Pattern::stall;
+            return stallEveryMs > stallForMs;
+        }
+
+        return false;
+    }
+
+    // Extra delay (seconds) before block `index` may go out.
+    double jitterDelay (uint64_t index, double period)
+    {
+        switch (pattern)
+        {
+            case Pattern::uniform:
+                if (index != delayedBlock)
+                {
+                    delayedBlock = index;
+                    currentDelay = std::uniform_real_distribution<double> (0.0, jitterMs * 1.0e-3) (random);
+                }
+                return currentDelay;
+
+            case Pattern::burst:
+                // Hold each block back until the last one of its group is due.
+                return (double) (burstBlocks - 1 - (int) (index % (uint64_t) burstBlocks)) * period;
+
+            case Pattern::none:
+            case Pattern::stall:
+                break;
+        }
+
+        return 0.0;
+    }
+
+    bool releaseAllowed (double elapsedSeconds) const
+    {
+        if (pattern != Pattern::stall)
+            return true;
+
+        const double phaseMs = std::fmod (elapsedSeconds * 1000.0, stallEveryMs);
+        return phaseMs >= stallForMs;
+    }
+
+    enum class Pattern { none, uniform, burst, stall };
+
+    static constexpr uint64_t timecodeMask = (uint64_t (1) << 24) - 1;
+    static constexpr uint64_t writeTimeSlots = 4096;
+
+    Options options;
+    int fd = -1;
+    void* segment = nullptr;
+    size_t segmentBytes = 0;
+    SharedAudioData* data = nullptr;            // Legacy layout
+    SegmentLayout::Header* header = nullptr;    // Self-describing layout
+    SegmentLayout::LiveFields live;
+    uint8_t* samples = nullptr;
+    uint64_t ringMask = 0;
+    StreamDirectory directory;
+    uint64_t writeIndex = 0;
+    uint64_t firstFrame = 0;    // writeIndex when we took over the segment
+    std::atomic<int64_t> writeTimes[writeTimeSlots] {};
+
+    int readerTableFd = -1;
+    ReaderTableLayout::Table* readerTable = nullptr;
+    SampleFormat::Encoding preferredEncoding = SampleFormat::float32;
+    SampleFormat::Encoding encoding = SampleFormat::float32;
+
+    Pattern pattern = Pattern::none;
+    double jitterMs = 0.0, stallEveryMs = 0.0, stallForMs = 0.0;
+    int burstBlocks = 1;
+    uint64_t delayedBlock = ~uint64_t (0);
+    double currentDelay = 0.0;
+    std::mt19937 random { 1234 };
+
+    int udpSocket = -1;
+    uint32_t sessionId = 0;
+    uint64_t sequence = 0;
+    std::atomic<uint64_t> framesSent { 0 };    // writeIndex for other threads
+    uint64_t datagramsSent = 0, datagramsDropped = 0;
+};
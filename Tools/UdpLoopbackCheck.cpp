@@ -0,0 +1,166 @@
+// Loopback check for the UDP transport (UdpReceiver.h).
+//
+// Runs a UdpReceiver on a local port and a StandInSender sending timecode to it over 127.0.0.1,
+// dropping every n-th datagram, then reads the receiver's segment the way the processor would.
+// Checks that every frame the sender produced lands in the ring at the same position (lost ones
+// filled in), that every drop was counted, and that only concealed frames and the fade-ins after
+// them differ from the timecode. Prints the counters and PASS or FAIL; the exit code follows.
+//
+// Usage: UdpLoopbackCheck [--port 47000] [--seconds 3] [--drop-every 50] [--block 256]
+
+#include "UdpReceiver.h"
+#include "StandInSender.h"
+
+#include <cinttypes>
+
+namespace
+{
+    void printUsage()
+    {
+        std::fprintf (stderr, "Usage: UdpLoopbackCheck [--port 47000] [--seconds 3] [--drop-every 50] [--block 256]\n");
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    int port = 47000, dropEvery = 50, blockSize = 256;
+    double seconds = 3.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg (argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--port" && hasValue)            port = std::atoi (argv[++i]);
+        else if (arg == "--seconds" && hasValue)    seconds = std::atof (argv[++i]);
+        else if (arg == "--drop-every" && hasValue) dropEvery = std::atoi (argv[++i]);
+        else if (arg == "--block" && hasValue)      blockSize = std::atoi (argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (port <= 0 || port > 65535 || seconds <= 0.0 || dropEvery == 1 || blockSize <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    UdpReceiver receiver;
+    std::string error;
+
+    if (! receiver.start ((uint16_t) port, UdpReceiver::defaultRingFrames, error))
+    {
+        std::fprintf (stderr, "Can't listen on UDP port %d: %s\n", port, error.c_str());
+        return 1;
+    }
+
+    StandInSender::Options options;
+    options.udpTarget = "127.0.0.1:" + std::to_string (port);
+    options.blockSize = blockSize;
+    options.timecode = true;
+    options.dropEvery = dropEvery;
+
+    StandInSender sender (options);
+
+    if (! sender.open())
+        return 1;
+
+    std::atomic<bool> keepRunning { true };
+    std::thread sending ([&] { sender.run (keepRunning, seconds); });
+
+    // Follow the ring like a reader, comparing every frame against the timecode it should carry.
+    const SegmentLayout::Header* header = nullptr;
+    SegmentLayout::LiveFields live;
+    const float* ring = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t readIndex = 0, mismatched = 0, overruns = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double> (seconds + 0.5);
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for (std::chrono::milliseconds (2));
+
+        if (header == nullptr)
+        {
+            const std::string name = receiver.getSegmentName();
+            const int fd = name.empty() ? -1 : shm_open (name.c_str(), O_RDONLY, 0);
+
+            if (fd == -1)
+                continue;
+
+            struct stat info {};
+            fstat (fd, &info);
+            void* mapped = mmap (nullptr, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close (fd);
+
+            if (mapped == MAP_FAILED)
+                continue;
+
+            header = static_cast<const SegmentLayout::Header*> (mapped);
+            mappedBytes = (size_t) info.st_size;
+
+            if (const char* reason = SegmentLayout::validate (*header, mappedBytes))
+            {
+                std::fprintf (stderr, "Receiver segment invalid: %s\n", reason);
+                return 1;
+            }
+
+            ring = reinterpret_cast<const float*> (static_cast<const uint8_t*> (mapped) + header->headerBytes);
+            live = SegmentLayout::locate (*const_cast<SegmentLayout::Header*> (header));
+        }
+
+        const uint64_t written = live.writeIndex->load (std::memory_order_acquire);
+        const uint64_t mask = header->ringFrames - 1;
+
+        if (written - readIndex > header->ringFrames)
+        {
+            ++overruns;
+            readIndex = written - header->ringFrames;
+        }
+
+        for (; readIndex < written; ++readIndex)
+        {
+            const float sample = ring[(readIndex & mask) * header->numChannels + StandInSender::dummyChannels];
+
+            if (sample != std::round (sample) || StandInSender::decodeTimecode (sample, readIndex) != readIndex)
+                ++mismatched;
+        }
+    }
+
+    keepRunning.store (false);
+    sending.join();
+
+    const auto& stats = receiver.getStats();
+    const uint64_t sent = sender.getWriteIndex();
+    const uint64_t dropped = sender.getDatagramsDropped();
+    const uint64_t lost = stats.lostPackets.load();
+    const uint64_t concealed = stats.concealedFrames.load();
+    const uint64_t framesPerDatagram = (uint64_t) std::min (blockSize, UdpAudioPacket::maxFramesPerDatagram (StandInSender::totalChannels, SampleFormat::float32));
+    const uint64_t fadeInFrames = (uint64_t) std::ceil (0.003 * options.sampleRate);
+
+    std::printf ("Sent %" PRIu64 " frames in %" PRIu64 " datagrams, dropped %" PRIu64 "\n", sent, sender.getDatagramsSent(), dropped);
+    std::printf ("Received %" PRIu64 " packets, %" PRIu64 " lost, %" PRIu64 " late, %" PRIu64 " malformed, %" PRIu64 " concealed frames\n",
+                 stats.packets.load(), lost, stats.latePackets.load(), stats.malformedPackets.load(), concealed);
+    std::printf ("Ring holds %" PRIu64 " frames, %" PRIu64 " differ from the timecode, %" PRIu64 " reader overruns\n",
+                 readIndex, mismatched, overruns);
+
+    // A drop at the very end can't be noticed (no later packet), so allow one datagram short.
+    bool ok = header != nullptr && overruns == 0;
+    ok = ok && readIndex <= sent && readIndex + framesPerDatagram >= sent;
+    ok = ok && lost <= dropped && lost + 1 >= dropped;
+    ok = ok && concealed >= lost && concealed <= lost * framesPerDatagram;   // Datagrams split blocks unevenly
+    ok = ok && mismatched <= concealed + lost * fadeInFrames;
+    ok = ok && (dropped > 0 || mismatched == 0);
+
+    if (header != nullptr)
+        munmap (const_cast<SegmentLayout::Header*> (header), mappedBytes);
+
+    sender.close();
+    receiver.stop();
+
+    std::printf ("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}